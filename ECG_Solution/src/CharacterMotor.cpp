@@ -0,0 +1,64 @@
+#include "CharacterMotor.h"
+
+using namespace physx;
+
+
+MovementIntent makeMovementIntent(unsigned int movementBits)
+{
+	MovementIntent intent;
+	if (movementBits & (1u << PFORWARD))
+		intent.direction.y += 1.0f;
+	if (movementBits & (1u << PBACKWARD))
+		intent.direction.y -= 1.0f;
+	if (movementBits & (1u << PRIGHT))
+		intent.direction.x += 1.0f;
+	if (movementBits & (1u << PLEFT))
+		intent.direction.x -= 1.0f;
+
+	float length = glm::length(intent.direction);
+	if (length > 1.0f)
+		intent.direction /= length;
+
+	intent.jump = (movementBits & (1u << PJUMP)) != 0;
+	return intent;
+}
+
+
+PxControllerCollisionFlags CharacterMotor::move(PxController& controller, const MovementIntent& intent, glm::vec3 front, glm::vec3 right, float deltaTime)
+{
+	if (intent.jump && _grounded)
+		_verticalVelocity = _jumpVelocity;
+	else
+		_verticalVelocity += _gravity * deltaTime;
+
+	// a camera looking straight up or down has no horizontal front, getNormalized gives zero then
+	PxVec3 forward = PxVec3(front.x, 0.0f, front.z).getNormalized();
+	PxVec3 sideways = PxVec3(right.x, 0.0f, right.z).getNormalized();
+	PxVec3 walk = (forward * intent.direction.y + sideways * intent.direction.x) * _speed;
+
+	PxVec3 displacement = (walk + PxVec3(0.0f, _verticalVelocity, 0.0f)) * deltaTime;
+	// stick to the ground, walking off a ledge still starts the fall from a standstill
+	if (_grounded && _verticalVelocity <= 0.0f && displacement.y > -_groundSnap)
+		displacement.y = -_groundSnap;
+	PxControllerCollisionFlags flags = controller.move(displacement, _minDistance, deltaTime, PxControllerFilters());
+
+	// standing stops the fall, a ceiling stops the jump
+	_grounded = flags.isSet(PxControllerCollisionFlag::eCOLLISION_DOWN);
+	if (_grounded && _verticalVelocity < 0.0f)
+		_verticalVelocity = 0.0f;
+	if (flags.isSet(PxControllerCollisionFlag::eCOLLISION_UP) && _verticalVelocity > 0.0f)
+		_verticalVelocity = 0.0f;
+
+	return flags;
+}
+
+void CharacterMotor::reset()
+{
+	_verticalVelocity = 0.0f;
+	_grounded = false;
+}
+
+bool CharacterMotor::isGrounded() const
+{
+	return _grounded;
+}
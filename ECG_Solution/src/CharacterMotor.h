@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "PxPhysicsAPI.h"
+
+
+//Abstraction of player movement
+enum Movement {
+
+	PFORWARD,
+	PBACKWARD,
+	PLEFT,
+	PRIGHT,
+	PJUMP,
+	PNOMOVEMENT,
+	PSPRINT
+};
+
+//what the player wants to do during a step, all keys of a frame together
+struct MovementIntent {
+
+	//x to the right, y forward, never longer than 1 so diagonals are as fast as straight lines
+	glm::vec2 direction = glm::vec2(0.0f);
+	bool jump = false;
+};
+
+//one bit per Movement, opposite keys cancel out
+MovementIntent makeMovementIntent(unsigned int movementBits);
+
+/*
+Moves the character controller of the player, exactly once per physics step.
+Walking and falling are added up into a single displacement, so a step costs one
+sweep of the controller against the scene no matter how many keys are held.
+Whether the player stands on something comes from the collision flags of that move.
+*/
+class CharacterMotor
+{
+private:
+	float _speed = 12.0f;
+	float _jumpVelocity = 7.0f;
+	float _gravity = -9.81f;
+	//smaller moves are ignored by the controller
+	float _minDistance = 0.02f;
+	//a grounded player is pushed down at least this far every step, one step of gravity is less than
+	//the min distance and would not reach the ground, so standing still would not count as standing
+	float _groundSnap = 0.05f;
+
+	float _verticalVelocity = 0.0f;
+	bool _grounded = false;
+
+public:
+	//front and right are the directions of the camera, only their horizontal part is used
+	physx::PxControllerCollisionFlags move(physx::PxController& controller, const MovementIntent& intent, glm::vec3 front, glm::vec3 right, float deltaTime);
+
+	//forgets the fall and the jump, for teleports
+	void reset();
+
+	bool isGrounded() const;
+};
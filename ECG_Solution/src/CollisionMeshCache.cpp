@@ -0,0 +1,221 @@
+#include "CollisionMeshCache.h"
+#include "Model.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace physx;
+
+
+//FNV-1a, good enough to tell meshes apart and stable across runs
+static void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+
+CollisionMeshCache::CollisionMeshCache(PxFoundation& foundation, PxPhysics& physics, const std::string& directory)
+	: _foundation(&foundation), _physics(&physics), _directory(directory)
+{
+	_registry = PxSerialization::createSerializationRegistry(physics);
+}
+
+CollisionMeshCache::~CollisionMeshCache()
+{
+	for (auto it = _meshes.begin(); it != _meshes.end(); ++it) {
+		it->second->release();
+	}
+	for (size_t i = 0; i < _memoryBlocks.size(); i++) {
+		std::free(_memoryBlocks[i]);
+	}
+	if (_cooking) {
+		_cooking->release();
+	}
+	_registry->release();
+}
+
+void CollisionMeshCache::collectTriangles(Model& model, std::vector<PxVec3>& points, std::vector<PxU32>& indices)
+{
+	for (size_t m = 0; m < model.meshes.size(); m++) {
+		const Mesh& mesh = model.meshes[m];
+		PxU32 offset = static_cast<PxU32>(points.size());
+
+		for (size_t v = 0; v < mesh.vertices.size(); v++) {
+			const glm::vec3& position = mesh.vertices[v].Position;
+			points.push_back(PxVec3(position.x, position.y, position.z));
+		}
+		for (size_t i = 0; i < mesh.indices.size(); i++) {
+			indices.push_back(offset + mesh.indices[i]);
+		}
+	}
+}
+
+uint64_t CollisionMeshCache::hashSource(CollisionMeshType type, const std::vector<PxVec3>& points, const std::vector<PxU32>& indices)
+{
+	uint64_t hash = 14695981039346656037ull;
+	hashBytes(hash, PX_BINARY_SERIAL_VERSION, std::strlen(PX_BINARY_SERIAL_VERSION));
+	hashBytes(hash, &type, sizeof(type));
+	if (!points.empty())
+		hashBytes(hash, points.data(), points.size() * sizeof(PxVec3));
+	// a convex hull only depends on the points
+	if (type == PTRIANGLEMESH && !indices.empty())
+		hashBytes(hash, indices.data(), indices.size() * sizeof(PxU32));
+	return hash;
+}
+
+PxConvexMesh* CollisionMeshCache::getConvexMesh(Model& model)
+{
+	PxBase* mesh = getMesh(model, PCONVEX);
+	return mesh ? mesh->is<PxConvexMesh>() : nullptr;
+}
+
+PxTriangleMesh* CollisionMeshCache::getTriangleMesh(Model& model)
+{
+	PxBase* mesh = getMesh(model, PTRIANGLEMESH);
+	return mesh ? mesh->is<PxTriangleMesh>() : nullptr;
+}
+
+uint64_t CollisionMeshCache::hashModel(Model& model, CollisionMeshType type)
+{
+	std::vector<PxVec3> points;
+	std::vector<PxU32> indices;
+	collectTriangles(model, points, indices);
+	return points.empty() ? 0 : hashSource(type, points, indices);
+}
+
+PxBase* CollisionMeshCache::getCachedMesh(uint64_t hash)
+{
+	auto it = _meshes.find(hash);
+	if (it != _meshes.end())
+		return it->second;
+
+	PxBase* mesh = load(getPath(hash));
+	if (!mesh)
+		return nullptr;
+
+	_loadedCount++;
+	_meshes[hash] = mesh;
+	return mesh;
+}
+
+PxBase* CollisionMeshCache::getMesh(Model& model, CollisionMeshType type)
+{
+	std::vector<PxVec3> points;
+	std::vector<PxU32> indices;
+	collectTriangles(model, points, indices);
+	if (points.empty())
+		return nullptr;
+
+	uint64_t hash = hashSource(type, points, indices);
+	PxBase* mesh = getCachedMesh(hash);
+	if (mesh)
+		return mesh;
+
+	std::string path = getPath(hash);
+	mesh = cook(type, points, indices);
+	if (!mesh) {
+		std::cout << "Failed to cook collision mesh " << path << std::endl;
+		return nullptr;
+	}
+	save(path, *mesh);
+	_cookedCount++;
+
+	_meshes[hash] = mesh;
+	return mesh;
+}
+
+std::string CollisionMeshCache::getPath(uint64_t hash)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.pxc", static_cast<unsigned long long>(hash));
+	return _directory + name;
+}
+
+PxBase* CollisionMeshCache::cook(CollisionMeshType type, const std::vector<PxVec3>& points, const std::vector<PxU32>& indices)
+{
+	if (!_cooking) {
+		_cooking = PxCreateCooking(PX_PHYSICS_VERSION, *_foundation, PxCookingParams(_physics->getTolerancesScale()));
+		if (!_cooking)
+			return nullptr;
+	}
+
+	if (type == PCONVEX) {
+		PxConvexMeshDesc desc;
+		desc.points.count = static_cast<PxU32>(points.size());
+		desc.points.stride = sizeof(PxVec3);
+		desc.points.data = points.data();
+		desc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+		return _cooking->createConvexMesh(desc, _physics->getPhysicsInsertionCallback());
+	}
+
+	PxTriangleMeshDesc desc;
+	desc.points.count = static_cast<PxU32>(points.size());
+	desc.points.stride = sizeof(PxVec3);
+	desc.points.data = points.data();
+	desc.triangles.count = static_cast<PxU32>(indices.size() / 3);
+	desc.triangles.stride = 3 * sizeof(PxU32);
+	desc.triangles.data = indices.data();
+	return _cooking->createTriangleMesh(desc, _physics->getPhysicsInsertionCallback());
+}
+
+PxBase* CollisionMeshCache::load(const std::string& path)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return nullptr;
+
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+
+	// the binary collection has to start at an aligned address, the block is kept for the lifetime of the mesh
+	void* block = std::malloc(size + PX_SERIAL_FILE_ALIGN);
+	void* aligned = reinterpret_cast<void*>((reinterpret_cast<size_t>(block) + PX_SERIAL_FILE_ALIGN - 1) & ~(size_t(PX_SERIAL_FILE_ALIGN) - 1));
+	size_t read = size > 0 ? std::fread(aligned, 1, size, file) : 0;
+	std::fclose(file);
+
+	PxCollection* collection = read == static_cast<size_t>(size) && size > 0 ? PxSerialization::createCollectionFromBinary(aligned, *_registry) : nullptr;
+	if (!collection) {
+		std::free(block);
+		return nullptr;
+	}
+
+	PxBase* mesh = nullptr;
+	for (PxU32 i = 0; i < collection->getNbObjects() && !mesh; i++) {
+		PxBase& object = collection->getObject(i);
+		if (object.is<PxConvexMesh>() || object.is<PxTriangleMesh>())
+			mesh = &object;
+	}
+	collection->release();
+
+	_memoryBlocks.push_back(block);
+	return mesh;
+}
+
+void CollisionMeshCache::save(const std::string& path, PxBase& mesh)
+{
+	PxCollection* collection = PxCreateCollection();
+	collection->add(mesh);
+	PxSerialization::complete(*collection, *_registry);
+
+	PxDefaultFileOutputStream stream(path.c_str());
+	if (!stream.isValid() || !PxSerialization::serializeCollectionToBinary(stream, *collection, *_registry)) {
+		std::cout << "Could not write collision cache " << path << std::endl;
+	}
+	collection->release();
+}
+
+unsigned int CollisionMeshCache::getCookedCount()
+{
+	return _cookedCount;
+}
+
+unsigned int CollisionMeshCache::getLoadedCount()
+{
+	return _loadedCount;
+}
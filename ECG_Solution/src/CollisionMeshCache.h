@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "PxPhysicsAPI.h"
+
+class Model;
+
+
+//kind of collider cooked from the triangles of a model
+enum CollisionMeshType {
+
+	PCONVEX,
+	PTRIANGLEMESH
+};
+
+/*
+Cooks convex and triangle mesh colliders from the mesh data of a Model.
+Every cooked mesh is written into its own binary PxCollection, named after a hash of
+the source triangles, so later runs load it with PxSerialization and never cook again.
+The cooking library is only created on the first cache miss.
+*/
+class CollisionMeshCache
+{
+private:
+	physx::PxFoundation* _foundation;
+	physx::PxPhysics* _physics;
+	physx::PxCooking* _cooking = nullptr;
+	physx::PxSerializationRegistry* _registry = nullptr;
+	std::string _directory;
+
+	//meshes of this run by source hash, a model that is used twice is only loaded once
+	std::map<uint64_t, physx::PxBase*> _meshes;
+	//deserialized collections live inside these blocks, they must outlive the meshes
+	std::vector<void*> _memoryBlocks;
+
+	unsigned int _cookedCount = 0;
+	unsigned int _loadedCount = 0;
+
+	physx::PxBase* getMesh(Model& model, CollisionMeshType type);
+	std::string getPath(uint64_t hash);
+	physx::PxBase* cook(CollisionMeshType type, const std::vector<physx::PxVec3>& points, const std::vector<physx::PxU32>& indices);
+	physx::PxBase* load(const std::string& path);
+	void save(const std::string& path, physx::PxBase& mesh);
+
+public:
+	//directory has to exist, cache files are written into it
+	CollisionMeshCache(physx::PxFoundation& foundation, physx::PxPhysics& physics, const std::string& directory);
+	~CollisionMeshCache();
+
+	//vertices of all meshes of the model in model space, the model matrix is not applied
+	static void collectTriangles(Model& model, std::vector<physx::PxVec3>& points, std::vector<physx::PxU32>& indices);
+
+	//hash of everything that goes into a cooked mesh, also changes with the PhysX binary format
+	static uint64_t hashSource(CollisionMeshType type, const std::vector<physx::PxVec3>& points, const std::vector<physx::PxU32>& indices);
+
+	//the source hash of a model, what its cooked collider is cached under, 0 for a model without triangles
+	static uint64_t hashModel(Model& model, CollisionMeshType type);
+
+	physx::PxConvexMesh* getConvexMesh(Model& model);
+	physx::PxTriangleMesh* getTriangleMesh(Model& model);
+
+	//a mesh cooked by an earlier run, found by its source hash alone, nullptr if it is not in the cache
+	physx::PxBase* getCachedMesh(uint64_t hash);
+
+	//meshes cooked during this run and meshes taken from the cache
+	unsigned int getCookedCount();
+	unsigned int getLoadedCount();
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Light.h"
+
+class Model;
+class Geometry;
+class ParticleEmitter;
+
+
+typedef uint32_t Entity;
+
+const Entity NO_ENTITY = 0xFFFFFFFF;
+
+//the way an entity is drawn, every pass is drawn with its own shader state
+enum RenderPass {
+
+	//plain geometry with its own material
+	PRENDER_GEOMETRY,
+	//a model with the shader it was loaded with
+	PRENDER_LIT,
+	//a model drawn with the normal mapping shader, the textures are bound once for the whole pass
+	PRENDER_NORMAL_MAPPED,
+	PRENDER_PASS_COUNT
+};
+
+//where the entity is, after it was added local and parent are only changed through TransformSystem.h
+struct TransformComponent {
+
+	//relative to the parent, to the world without one
+	glm::mat4 local = glm::mat4(1.0f);
+	//the world of the parent times local, recomputed by updateTransforms only when dirty
+	glm::mat4 world = glm::mat4(1.0f);
+	//inverse transpose of the upper 3x3 of world, what the normals are transformed with
+	glm::mat3 normal = glm::mat3(1.0f);
+	Entity parent = NO_ENTITY;
+	//local or the parent changed since the last update
+	bool dirty = true;
+	//world changed in the last update, the children of the entity follow it
+	bool moved = false;
+};
+
+//what is drawn at the transform, several entities share the same model or geometry
+struct RenderComponent {
+
+	Model* model = nullptr;
+	Geometry* geometry = nullptr;
+	RenderPass pass = PRENDER_LIT;
+};
+
+//a moving body of the physics world, its interpolated render pose is copied into the local transform every frame
+struct PhysicsComponent {
+
+	size_t body = 0;
+};
+
+//the path an enemy walks, the index of its patrol in the physics world
+struct PathComponent {
+
+	size_t patrol = 0;
+};
+
+struct LightComponent {
+
+	PointLight light;
+};
+
+//the particle manager keeps ownership of the emitter
+struct EmitterComponent {
+
+	ParticleEmitter* emitter = nullptr;
+};
@@ -9,7 +9,7 @@ Enemy::Enemy(std::vector<physx::PxVec3> controlPoints, Model* enemyModel)
 {
 }
 
-std::vector<physx::PxVec3> Enemy::getControlPoints()
+const std::vector<physx::PxVec3>& Enemy::getControlPoints()
 {
 	return controlPoints;
 }
@@ -14,7 +14,7 @@ private:
 public:
 	Enemy(std::vector<physx::PxVec3> controlPoints, Model* enemyModel);
 
-	std::vector<physx::PxVec3> getControlPoints();
+	const std::vector<physx::PxVec3>& getControlPoints();
 
 	uint16_t getControlPointIndex();
 
@@ -0,0 +1,253 @@
+#include "FrameArena.h"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+
+namespace {
+
+	std::atomic<uint64_t> g_arenaFrame(1);
+	std::atomic<size_t> g_defaultCapacity(1024 * 1024);
+
+	//shared with the replaced operator new below, any thread may allocate while a frame is guarded
+	std::atomic<bool> g_heapGuardActive(false);
+	std::atomic<bool> g_heapGuardAsserts(false);
+	std::atomic<uint64_t> g_heapAllocations(0);
+
+	//an overflow block starts with the pointer to the previous one
+	struct OverflowBlock {
+
+		OverflowBlock* previous;
+	};
+
+	void* alignPointer(char* pointer, size_t alignment)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		return reinterpret_cast<void*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+}
+
+
+/* --------------------------------------------- */
+// Global heap
+/* --------------------------------------------- */
+
+// the arenas take their blocks straight from malloc, so only the general heap is counted here
+void* operator new(size_t size)
+{
+	if (g_heapGuardActive.load(std::memory_order_relaxed)) {
+		g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+#ifndef NDEBUG
+		if (g_heapGuardAsserts.load(std::memory_order_relaxed)) {
+			// the assertion allocates itself
+			g_heapGuardActive.store(false);
+			assert(!"heap allocation in a guarded frame, use the frame arena");
+		}
+#endif
+	}
+
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+
+/* --------------------------------------------- */
+// Frame arena
+/* --------------------------------------------- */
+
+FrameArena::FrameArena(size_t capacity)
+	: _capacity(capacity)
+{
+}
+
+FrameArena::~FrameArena()
+{
+	reset();
+	std::free(_block);
+}
+
+void FrameArena::syncFrame()
+{
+	uint64_t frame = g_arenaFrame.load(std::memory_order_acquire);
+	if (frame != _frame) {
+		reset();
+		_frame = frame;
+	}
+}
+
+void FrameArena::reset()
+{
+	OverflowBlock* block = reinterpret_cast<OverflowBlock*>(_overflow);
+	while (block) {
+		OverflowBlock* previous = block->previous;
+		std::free(block);
+		block = previous;
+	}
+	_overflow = nullptr;
+
+	// the next frame gets a single block that would have held this one
+	if (_overflowBytes > 0) {
+		_capacity += _overflowBytes;
+		_overflowBytes = 0;
+		std::free(_block);
+		_block = nullptr;
+	}
+	_used = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	syncFrame();
+
+	if (!_block) {
+		_block = static_cast<char*>(std::malloc(_capacity));
+		if (!_block)
+			throw std::bad_alloc();
+	}
+
+	char* aligned = static_cast<char*>(alignPointer(_block + _used, alignment));
+	size_t end = (aligned - _block) + size;
+	if (end <= _capacity) {
+		_used = end;
+		if (getUsed() > _peak)
+			_peak = getUsed();
+		return aligned;
+	}
+
+	// too big for this frame, the block grows on the next reset
+	size_t bytes = sizeof(OverflowBlock) + size + alignment;
+	OverflowBlock* block = static_cast<OverflowBlock*>(std::malloc(bytes));
+	if (!block)
+		throw std::bad_alloc();
+	block->previous = reinterpret_cast<OverflowBlock*>(_overflow);
+	_overflow = block;
+	_overflowBytes += size + alignment;
+	if (getUsed() > _peak)
+		_peak = getUsed();
+
+	return alignPointer(reinterpret_cast<char*>(block + 1), alignment);
+}
+
+size_t FrameArena::getUsed() const
+{
+	return _used + _overflowBytes;
+}
+
+size_t FrameArena::getPeak() const
+{
+	return _peak;
+}
+
+size_t FrameArena::getCapacity() const
+{
+	return _capacity;
+}
+
+FrameArena& FrameArena::local()
+{
+	thread_local FrameArena arena(g_defaultCapacity.load());
+	return arena;
+}
+
+void FrameArena::beginFrame()
+{
+	g_arenaFrame.fetch_add(1, std::memory_order_release);
+}
+
+void FrameArena::setDefaultCapacity(size_t capacity)
+{
+	g_defaultCapacity.store(capacity > 0 ? capacity : 1);
+}
+
+
+/* --------------------------------------------- */
+// Heap guard
+/* --------------------------------------------- */
+
+HeapGuardMode parseHeapGuardMode(const std::string& name)
+{
+	if (name == "report")
+		return PHEAP_REPORT;
+	if (name == "assert")
+		return PHEAP_ASSERT;
+	return PHEAP_OFF;
+}
+
+FrameHeapGuard::FrameHeapGuard(HeapGuardMode mode, unsigned int warmupFrames)
+	: _mode(mode), _warmupFrames(warmupFrames)
+{
+	g_heapGuardAsserts.store(mode == PHEAP_ASSERT);
+}
+
+FrameHeapGuard::~FrameHeapGuard()
+{
+	g_heapGuardActive.store(false);
+}
+
+void FrameHeapGuard::beginFrame()
+{
+	if (_mode == PHEAP_OFF)
+		return;
+
+	if (_framesSinceStart < _warmupFrames) {
+		_framesSinceStart++;
+		return;
+	}
+
+	_guarding = true;
+	g_heapAllocations.store(0);
+	g_heapGuardActive.store(true);
+}
+
+void FrameHeapGuard::endFrame()
+{
+	if (!_guarding)
+		return;
+
+	g_heapGuardActive.store(false);
+	_guarding = false;
+
+	uint64_t allocations = g_heapAllocations.load();
+	_guardedFrames++;
+	if (allocations == 0)
+		return;
+
+	_allocatingFrames++;
+	_allocations += allocations;
+
+	// only the first frames, a leak in every frame would flood the console
+	if (_allocatingFrames <= 10)
+		std::cout << "Heap guard: guarded frame " << _guardedFrames << " allocated " << allocations << " times on the heap" << std::endl;
+}
+
+void FrameHeapGuard::restart()
+{
+	if (_guarding) {
+		g_heapGuardActive.store(false);
+		_guarding = false;
+	}
+	_framesSinceStart = 0;
+}
+
+void FrameHeapGuard::printSummary() const
+{
+	if (_mode == PHEAP_OFF)
+		return;
+
+	std::cout << "Heap guard: " << _allocatingFrames << " of " << _guardedFrames << " guarded frames allocated, "
+		<< _allocations << " allocations in total" << std::endl;
+}
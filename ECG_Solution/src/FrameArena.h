@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/*
+A bump allocator for data that only lives until the end of the frame.
+Every thread has its own arena, so jobs allocate without any lock. Allocating moves
+an offset, freeing does nothing and the whole arena is reset at once. An arena resets
+itself on its first allocation after beginFrame, so no thread ever touches the arena
+of another one. A frame that does not fit gets extra blocks from the heap, the next
+frame then starts with a single block that is big enough.
+Nothing allocated from an arena may be kept past the next beginFrame.
+*/
+class FrameArena
+{
+private:
+	char* _block = nullptr;
+	size_t _capacity = 0;
+	size_t _used = 0;
+
+	//list of the blocks of a frame that did not fit, freed and merged into the next block on reset
+	void* _overflow = nullptr;
+	size_t _overflowBytes = 0;
+
+	size_t _peak = 0;
+	uint64_t _frame = 0;
+
+	//resets the arena if a new frame began since its last allocation
+	void syncFrame();
+	void reset();
+
+public:
+	FrameArena(size_t capacity);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	//alignment has to be a power of two
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	//bytes handed out this frame, including the overflow
+	size_t getUsed() const;
+	//most bytes a single frame needed so far
+	size_t getPeak() const;
+	size_t getCapacity() const;
+
+	//the arena of the calling thread, created with the default capacity on first use
+	static FrameArena& local();
+
+	//every arena starts over with its next allocation, call once at the start of the frame
+	static void beginFrame();
+
+	//capacity of the arenas that are created from now on
+	static void setDefaultCapacity(size_t capacity);
+};
+
+//allocates from a frame arena, deallocate does nothing
+template <typename T>
+class ArenaAllocator
+{
+private:
+	template <typename U>
+	friend class ArenaAllocator;
+
+	FrameArena* _arena;
+
+public:
+	typedef T value_type;
+
+	//the arena of the calling thread
+	ArenaAllocator() : _arena(&FrameArena::local()) {}
+	explicit ArenaAllocator(FrameArena& arena) : _arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other._arena) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return _arena == other._arena;
+	}
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return _arena != other._arena;
+	}
+};
+
+//containers for data of a single frame, their memory is gone with the next beginFrame
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> FrameString;
+
+
+//what happens to allocations of the general heap inside a guarded frame
+enum HeapGuardMode {
+
+	PHEAP_OFF,
+	//count them and print the frames that allocated
+	PHEAP_REPORT,
+	//like report, debug builds also stop at the allocation with an assertion
+	PHEAP_ASSERT
+};
+
+//"report" or "assert", anything else is off
+HeapGuardMode parseHeapGuardMode(const std::string& name);
+
+/*
+Checks that the steady state frames do not touch the general heap.
+Every operator new of any thread between beginFrame and endFrame is counted, the
+first frames after a start or a pause are not guarded since caches still fill up.
+*/
+class FrameHeapGuard
+{
+private:
+	HeapGuardMode _mode;
+	unsigned int _warmupFrames;
+	unsigned int _framesSinceStart = 0;
+	bool _guarding = false;
+
+	unsigned int _guardedFrames = 0;
+	unsigned int _allocatingFrames = 0;
+	uint64_t _allocations = 0;
+
+public:
+	FrameHeapGuard(HeapGuardMode mode, unsigned int warmupFrames = 120);
+	~FrameHeapGuard();
+
+	void beginFrame();
+	void endFrame();
+
+	//warms up again, for frames that follow a pause or a level change
+	void restart();
+
+	//prints how many of the guarded frames allocated
+	void printSummary() const;
+};
@@ -0,0 +1,162 @@
+#include "FramePacer.h"
+#include <thread>
+#include <cmath>
+#include "Utils.h"
+
+#ifdef _WIN32
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+
+//added to the measured overshoot of a sleep, the spin margin never goes below it
+static const double SPIN_SAFETY_US = 250.0;
+//a sleep that overshoots more than this is an outlier, spinning longer would only burn the core
+static const double MAX_SPIN_MARGIN_US = 4000.0;
+
+
+PacingMode parsePacingMode(const std::string& name)
+{
+	if (name == "adaptive")
+		return PPACE_ADAPTIVE;
+	if (name == "uncapped")
+		return PPACE_UNCAPPED;
+	return PPACE_VSYNC;
+}
+
+
+FramePacer::FramePacer(size_t history)
+	: _frameTimes(history > 0 ? history : 1, 0.0f)
+{
+#ifdef _WIN32
+	// the default scheduler tick of about 15 ms makes every sleep far too coarse
+	_timerResolutionRaised = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (_timerResolutionRaised)
+		timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::configure(PacingMode mode, float targetFps)
+{
+	_mode = mode;
+	_targetFps = targetFps > 0.0f ? targetFps : 0.0f;
+	_period = _targetFps > 0.0f ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _targetFps)) : Clock::duration::zero();
+	_hasDeadline = false;
+
+	int interval = 1;
+	if (mode == PPACE_UNCAPPED) {
+		interval = 0;
+	}
+	else if (mode == PPACE_ADAPTIVE && (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))) {
+		// a negative interval swaps late frames immediately
+		interval = -1;
+	}
+	glfwSwapInterval(interval);
+}
+
+PacingMode FramePacer::getMode() const
+{
+	return _mode;
+}
+
+float FramePacer::getTargetFps() const
+{
+	return _targetFps;
+}
+
+void FramePacer::sleepUntil(Clock::time_point deadline)
+{
+	Clock::time_point now = Clock::now();
+	Clock::duration margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(_spinMarginUs));
+
+	if (deadline - now > margin) {
+		Clock::time_point wakeUp = deadline - margin;
+		std::this_thread::sleep_for(wakeUp - now);
+
+		// a bad sleep raises the margin at once, good ones lower it slowly
+		double overshootUs = std::chrono::duration<double, std::micro>(Clock::now() - wakeUp).count() + SPIN_SAFETY_US;
+		if (overshootUs > _spinMarginUs)
+			_spinMarginUs = overshootUs < MAX_SPIN_MARGIN_US ? overshootUs : MAX_SPIN_MARGIN_US;
+		else
+			_spinMarginUs = _spinMarginUs * 0.98 + overshootUs * 0.02;
+	}
+
+	// the last bit is spun, a sleep can not hit it that exactly
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::waitForNextFrame()
+{
+	if (_period == Clock::duration::zero())
+		return;
+
+	Clock::time_point now = Clock::now();
+
+	// a frame that is more than a whole period late starts the schedule over instead of rushing the following ones
+	if (!_hasDeadline || now - _deadline > _period) {
+		_deadline = now;
+		_hasDeadline = true;
+	}
+	else if (now < _deadline) {
+		sleepUntil(_deadline);
+	}
+	_deadline += _period;
+}
+
+void FramePacer::frameSwapped()
+{
+	Clock::time_point now = Clock::now();
+	if (_hasSwapped) {
+		_frameTimes[_nextFrameTime] = std::chrono::duration<float, std::milli>(now - _lastSwap).count();
+		_nextFrameTime = (_nextFrameTime + 1) % _frameTimes.size();
+		if (_frameTimeCount < _frameTimes.size())
+			_frameTimeCount++;
+	}
+	_lastSwap = now;
+	_hasSwapped = true;
+}
+
+void FramePacer::restart()
+{
+	_hasDeadline = false;
+	_hasSwapped = false;
+}
+
+FramePacingStats FramePacer::getStats() const
+{
+	FramePacingStats stats;
+	if (_frameTimeCount == 0)
+		return stats;
+
+	double sum = 0.0;
+	stats.minMs = _frameTimes[0];
+	stats.maxMs = _frameTimes[0];
+	for (size_t i = 0; i < _frameTimeCount; i++) {
+		float frameTime = _frameTimes[i];
+		sum += frameTime;
+		stats.minMs = frameTime < stats.minMs ? frameTime : stats.minMs;
+		stats.maxMs = frameTime > stats.maxMs ? frameTime : stats.maxMs;
+	}
+	double average = sum / _frameTimeCount;
+
+	double variance = 0.0;
+	for (size_t i = 0; i < _frameTimeCount; i++) {
+		double difference = _frameTimes[i] - average;
+		variance += difference * difference;
+	}
+	variance /= _frameTimeCount;
+
+	stats.frames = static_cast<unsigned int>(_frameTimeCount);
+	stats.averageMs = static_cast<float>(average);
+	stats.deviationMs = static_cast<float>(std::sqrt(variance));
+	stats.fps = average > 0.0 ? static_cast<float>(1000.0 / average) : 0.0f;
+	return stats;
+}
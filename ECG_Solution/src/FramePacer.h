@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+//how the swaps are synchronized with the display
+enum PacingMode {
+
+	//wait for the vertical blank on every swap
+	PPACE_VSYNC,
+	//vsync, but a late frame is shown right away instead of waiting for the next blank, plain vsync if the driver can not do it
+	PPACE_ADAPTIVE,
+	//never wait for the display, only the target fps limits the frame rate
+	PPACE_UNCAPPED
+};
+
+//"vsync", "adaptive" or "uncapped", anything else is vsync
+PacingMode parsePacingMode(const std::string& name);
+
+//frame times measured from swap to swap over the recent frames
+struct FramePacingStats {
+
+	float fps = 0.0f;
+	float averageMs = 0.0f;
+	//standard deviation, how uneven the frames are delivered
+	float deviationMs = 0.0f;
+	float minMs = 0.0f;
+	float maxMs = 0.0f;
+	unsigned int frames = 0;
+};
+
+/*
+Keeps the frames of the render loop at a steady rate.
+The swap interval follows the pacing mode, a target fps on top of it is reached by
+sleeping most of the remaining frame time and spinning the rest. The spin margin
+learns how much the sleeps of this machine overshoot, so the frame starts within a
+fraction of a millisecond without burning a core for the whole wait.
+*/
+class FramePacer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+private:
+	PacingMode _mode = PPACE_VSYNC;
+	float _targetFps = 0.0f;
+	Clock::duration _period = Clock::duration::zero();
+	Clock::time_point _deadline;
+	bool _hasDeadline = false;
+
+	//how much a sleep is expected to overshoot, the rest of the wait is spun
+	double _spinMarginUs = 1000.0;
+
+	//swap to swap times of the recent frames
+	std::vector<float> _frameTimes;
+	size_t _nextFrameTime = 0;
+	size_t _frameTimeCount = 0;
+	Clock::time_point _lastSwap;
+	bool _hasSwapped = false;
+
+	bool _timerResolutionRaised = false;
+
+	void sleepUntil(Clock::time_point deadline);
+
+public:
+	FramePacer(size_t history = 120);
+	~FramePacer();
+
+	//sets the swap interval of the current context, a target fps of 0 does not limit the frame rate
+	void configure(PacingMode mode, float targetFps);
+
+	PacingMode getMode() const;
+	float getTargetFps() const;
+
+	//call right before the swap, waits until the next frame is due
+	void waitForNextFrame();
+
+	//call right after the swap
+	void frameSwapped();
+
+	//forgets the schedule and the last swap, for frames that follow a pause
+	void restart();
+
+	FramePacingStats getStats() const;
+};
@@ -0,0 +1,395 @@
+#include "FrameProfiler.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+
+
+//track of the GPU passes in the trace, far away from the thread indices
+static const uint32_t GPU_TRACK = 1000;
+static const size_t NO_QUERY = SIZE_MAX;
+
+struct OpenScope {
+	const char* name;
+	FrameProfiler::Clock::time_point start;
+	//false if the profiler was off when the scope began
+	bool recorded;
+};
+
+//open scopes and index of the calling thread
+static thread_local std::vector<OpenScope> tlsScopes;
+static thread_local uint32_t tlsThread = UINT_MAX;
+
+
+//names are not escaped by anybody else, PhysX zone names could contain anything
+static void writeJsonString(std::ostream& stream, const char* text)
+{
+	stream << '"';
+	for (const char* c = text ? text : ""; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			stream << '\\';
+		stream << *c;
+	}
+	stream << '"';
+}
+
+static void writeTraceEvent(std::ostream& stream, const ProfileEvent& event, bool& first)
+{
+	stream << (first ? "\n" : ",\n") << "{\"name\":";
+	writeJsonString(stream, event.name);
+	stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+	first = false;
+}
+
+//adds the events of one frame to the summary, ordered by start time so parents come before their children
+static void summarizeEvents(FrameVector<ProfileSummary>& summary, const std::vector<ProfileEvent>& events, bool gpu, uint32_t thread, uint32_t maxDepth)
+{
+	FrameVector<const ProfileEvent*> ordered;
+	for (size_t i = 0; i < events.size(); i++) {
+		if ((gpu || events[i].thread == thread) && events[i].depth <= maxDepth)
+			ordered.push_back(&events[i]);
+	}
+	std::sort(ordered.begin(), ordered.end(), [](const ProfileEvent* a, const ProfileEvent* b) { return a->startUs < b->startUs; });
+
+	for (size_t i = 0; i < ordered.size(); i++) {
+		const ProfileEvent& event = *ordered[i];
+		ProfileSummary* entry = nullptr;
+		for (size_t j = 0; j < summary.size() && !entry; j++) {
+			if (summary[j].gpu == gpu && summary[j].depth == event.depth && std::strcmp(summary[j].name, event.name) == 0)
+				entry = &summary[j];
+		}
+		if (!entry) {
+			summary.push_back(ProfileSummary());
+			entry = &summary.back();
+			entry->name = event.name;
+			entry->depth = event.depth;
+			entry->gpu = gpu;
+		}
+		// summed up here, divided by the number of frames at the end
+		entry->averageMs += event.durationUs / 1000.0;
+	}
+}
+
+
+FrameProfiler::FrameProfiler()
+	: _enabled(false), _origin(Clock::now()), _frames(240), _nextThread(0)
+{
+}
+
+FrameProfiler& FrameProfiler::get()
+{
+	static FrameProfiler profiler;
+	return profiler;
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+	_enabled = enabled;
+}
+
+bool FrameProfiler::isEnabled() const
+{
+	return _enabled;
+}
+
+void FrameProfiler::enableGpuTimers()
+{
+	_gpuEnabled = true;
+}
+
+void FrameProfiler::setHistory(size_t frames)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_frames.assign(frames > 0 ? frames : 1, ProfiledFrame());
+}
+
+double FrameProfiler::toUs(Clock::time_point time) const
+{
+	return std::chrono::duration<double, std::micro>(time - _origin).count();
+}
+
+uint32_t FrameProfiler::getThreadIndex()
+{
+	if (tlsThread == UINT_MAX) {
+		tlsThread = _nextThread.fetch_add(1);
+		if (_threadNames.size() <= tlsThread)
+			_threadNames.resize(tlsThread + 1);
+		_threadNames[tlsThread] = "thread " + std::to_string(tlsThread);
+	}
+	return tlsThread;
+}
+
+ProfiledFrame& FrameProfiler::currentFrame()
+{
+	return _frames[_frameCount % _frames.size()];
+}
+
+void FrameProfiler::readGpuQueries(GpuQuerySet& set)
+{
+	set.pending = false;
+
+	// the last query of the frame is the last one the GPU gets to, if it is not there yet the frame is dropped
+	GLint available = 0;
+	glGetQueryObjectiv(set.end[set.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	ProfiledFrame& frame = _frames[set.frame % _frames.size()];
+	if (frame.index != set.frame || !frame.finished)
+		return;
+
+	frame.gpuEvents.resize(set.used);
+	for (size_t i = 0; i < set.used; i++) {
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(set.begin[i], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(set.end[i], GL_QUERY_RESULT, &end);
+
+		ProfileEvent& event = frame.gpuEvents[i];
+		event.name = set.names[i];
+		event.thread = GPU_TRACK;
+		event.depth = set.depths[i];
+		event.startUs = set.cpuOriginUs + (static_cast<double>(begin) - static_cast<double>(set.gpuOrigin)) / 1000.0;
+		event.durationUs = (static_cast<double>(end) - static_cast<double>(begin)) / 1000.0;
+	}
+}
+
+void FrameProfiler::beginFrame()
+{
+	if (!_enabled) {
+		_inFrame = false;
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+
+	if (_gpuEnabled) {
+		GpuQuerySet& set = _gpuSets[_frameCount % GPU_LATENCY];
+		if (set.pending)
+			readGpuQueries(set);
+
+		set.used = 0;
+		set.frame = _frameCount;
+		glGetInteger64v(GL_TIMESTAMP, &set.gpuOrigin);
+		set.cpuOriginUs = toUs(now);
+		_gpuOpen.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_mainThread = getThreadIndex();
+	_threadNames[_mainThread] = "main";
+
+	ProfiledFrame& frame = currentFrame();
+	frame.index = _frameCount;
+	frame.startUs = toUs(now);
+	frame.durationUs = 0.0;
+	frame.cpuEvents.clear();
+	frame.gpuEvents.clear();
+	frame.finished = false;
+	_inFrame = true;
+}
+
+void FrameProfiler::endFrame()
+{
+	if (!_inFrame)
+		return;
+
+	if (_gpuEnabled) {
+		GpuQuerySet& set = _gpuSets[_frameCount % GPU_LATENCY];
+		set.pending = set.used > 0;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	ProfiledFrame& frame = currentFrame();
+	frame.durationUs = toUs(Clock::now()) - frame.startUs;
+	frame.finished = true;
+	_inFrame = false;
+	_frameCount++;
+}
+
+void FrameProfiler::beginScope(const char* name)
+{
+	OpenScope scope;
+	scope.name = name;
+	scope.recorded = _enabled.load(std::memory_order_relaxed);
+	if (scope.recorded)
+		scope.start = Clock::now();
+	tlsScopes.push_back(scope);
+}
+
+void FrameProfiler::endScope()
+{
+	if (tlsScopes.empty())
+		return;
+
+	OpenScope scope = tlsScopes.back();
+	tlsScopes.pop_back();
+	if (scope.recorded && _enabled.load(std::memory_order_relaxed))
+		addEvent(scope.name, scope.start, Clock::now(), static_cast<uint32_t>(tlsScopes.size()));
+}
+
+void FrameProfiler::addScope(const char* name, Clock::time_point start, Clock::time_point end)
+{
+	if (_enabled.load(std::memory_order_relaxed))
+		addEvent(name, start, end, static_cast<uint32_t>(tlsScopes.size()));
+}
+
+void FrameProfiler::addEvent(const char* name, Clock::time_point start, Clock::time_point end, uint32_t depth)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_inFrame)
+		return;
+
+	ProfileEvent event;
+	event.name = name;
+	event.thread = getThreadIndex();
+	event.depth = depth;
+	event.startUs = toUs(start);
+	event.durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+	currentFrame().cpuEvents.push_back(event);
+}
+
+void FrameProfiler::beginGpuScope(const char* name)
+{
+	if (!_inFrame || !_gpuEnabled) {
+		_gpuOpen.push_back(NO_QUERY);
+		return;
+	}
+
+	GpuQuerySet& set = _gpuSets[_frameCount % GPU_LATENCY];
+	if (set.used == set.begin.size()) {
+		GLuint queries[2];
+		glGenQueries(2, queries);
+		set.begin.push_back(queries[0]);
+		set.end.push_back(queries[1]);
+		set.names.push_back(nullptr);
+		set.depths.push_back(0);
+	}
+
+	size_t slot = set.used++;
+	set.names[slot] = name;
+	set.depths[slot] = static_cast<uint32_t>(_gpuOpen.size());
+	glQueryCounter(set.begin[slot], GL_TIMESTAMP);
+	_gpuOpen.push_back(slot);
+}
+
+void FrameProfiler::endGpuScope()
+{
+	if (_gpuOpen.empty())
+		return;
+
+	size_t slot = _gpuOpen.back();
+	_gpuOpen.pop_back();
+	if (slot != NO_QUERY)
+		glQueryCounter(_gpuSets[_frameCount % GPU_LATENCY].end[slot], GL_TIMESTAMP);
+}
+
+void FrameProfiler::beginPass(const char* name)
+{
+	beginScope(name);
+	beginGpuScope(name);
+}
+
+void FrameProfiler::endPass()
+{
+	endGpuScope();
+	endScope();
+}
+
+FrameVector<ProfileSummary> FrameProfiler::summarize(unsigned int frames, uint32_t maxDepth)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	FrameVector<ProfileSummary> cpu;
+	FrameVector<ProfileSummary> gpu;
+	unsigned int cpuFrames = 0;
+	unsigned int gpuFrames = 0;
+
+	// newest first, the GPU passes of the last few frames are not there yet
+	uint64_t available = std::min<uint64_t>(_frameCount, _frames.size());
+	for (uint64_t n = 0; n < available && n < frames; n++) {
+		const ProfiledFrame& frame = _frames[(_frameCount - 1 - n) % _frames.size()];
+		if (!frame.finished)
+			continue;
+
+		summarizeEvents(cpu, frame.cpuEvents, false, _mainThread, maxDepth);
+		cpuFrames++;
+		if (!frame.gpuEvents.empty()) {
+			summarizeEvents(gpu, frame.gpuEvents, true, GPU_TRACK, maxDepth);
+			gpuFrames++;
+		}
+	}
+
+	for (size_t i = 0; i < cpu.size(); i++) {
+		cpu[i].averageMs /= cpuFrames;
+		cpu[i].frames = cpuFrames;
+	}
+	for (size_t i = 0; i < gpu.size(); i++) {
+		gpu[i].averageMs /= gpuFrames;
+		gpu[i].frames = gpuFrames;
+	}
+	cpu.insert(cpu.end(), gpu.begin(), gpu.end());
+	return cpu;
+}
+
+double FrameProfiler::getAverageFrameMs(unsigned int frames)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	double total = 0.0;
+	unsigned int count = 0;
+	uint64_t available = std::min<uint64_t>(_frameCount, _frames.size());
+	for (uint64_t n = 0; n < available && n < frames; n++) {
+		const ProfiledFrame& frame = _frames[(_frameCount - 1 - n) % _frames.size()];
+		if (frame.finished) {
+			total += frame.durationUs / 1000.0;
+			count++;
+		}
+	}
+	return count > 0 ? total / count : 0.0;
+}
+
+bool FrameProfiler::exportChromeTrace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	file.setf(std::ios::fixed);
+	file.precision(3);
+
+	bool first = true;
+	file << "{\"traceEvents\":[";
+	for (size_t i = 0; i < _threadNames.size(); i++) {
+		file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+		writeJsonString(file, _threadNames[i].c_str());
+		file << "}}";
+		first = false;
+	}
+	file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+	first = false;
+
+	// oldest frame first
+	uint64_t available = std::min<uint64_t>(_frameCount, _frames.size());
+	for (uint64_t n = available; n > 0; n--) {
+		const ProfiledFrame& frame = _frames[(_frameCount - n) % _frames.size()];
+		if (!frame.finished)
+			continue;
+
+		ProfileEvent frameEvent;
+		frameEvent.name = "frame";
+		frameEvent.thread = _mainThread;
+		frameEvent.startUs = frame.startUs;
+		frameEvent.durationUs = frame.durationUs;
+		writeTraceEvent(file, frameEvent, first);
+
+		for (size_t i = 0; i < frame.cpuEvents.size(); i++)
+			writeTraceEvent(file, frame.cpuEvents[i], first);
+		for (size_t i = 0; i < frame.gpuEvents.size(); i++)
+			writeTraceEvent(file, frame.gpuEvents[i], first);
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <GL/glew.h>
+#include "FrameArena.h"
+
+
+//one measured scope, times in microseconds since the profiler was created
+struct ProfileEvent {
+
+	const char* name = nullptr;
+	uint32_t thread = 0;
+	uint32_t depth = 0;
+	double startUs = 0.0;
+	double durationUs = 0.0;
+};
+
+struct ProfiledFrame {
+
+	uint64_t index = 0;
+	double startUs = 0.0;
+	double durationUs = 0.0;
+	std::vector<ProfileEvent> cpuEvents;
+	//filled in a few frames later, once the GPU is done with the frame
+	std::vector<ProfileEvent> gpuEvents;
+	bool finished = false;
+};
+
+//average time of one scope over the frames in the history
+struct ProfileSummary {
+
+	const char* name = nullptr;
+	uint32_t depth = 0;
+	bool gpu = false;
+	double averageMs = 0.0;
+	unsigned int frames = 0;
+};
+
+/*
+Collects nested CPU scopes from every thread and GPU timings of the render passes,
+frame by frame, into a ring buffer of the most recent frames.
+GPU passes are measured with GL_TIMESTAMP queries at their begin and end, so they can
+be nested. The queries of a frame are read back GPU_LATENCY frames later, when the
+results are there, and never stall the pipeline.
+Everything is off until it is enabled, a scope then costs a single flag check.
+*/
+class FrameProfiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	//frames the GPU queries of a frame are kept before they are read
+	static const unsigned int GPU_LATENCY = 3;
+
+private:
+	struct GpuQuerySet {
+		std::vector<GLuint> begin;
+		std::vector<GLuint> end;
+		std::vector<const char*> names;
+		std::vector<uint32_t> depths;
+		size_t used = 0;
+		uint64_t frame = 0;
+		bool pending = false;
+		//GPU and CPU clock at the start of the frame, to put the GPU passes on the CPU timeline
+		GLint64 gpuOrigin = 0;
+		double cpuOriginUs = 0.0;
+	};
+
+	std::atomic<bool> _enabled;
+	bool _gpuEnabled = false;
+	Clock::time_point _origin;
+
+	std::mutex _mutex;
+	std::vector<ProfiledFrame> _frames;
+	uint64_t _frameCount = 0;
+	bool _inFrame = false;
+	uint32_t _mainThread = 0;
+	std::vector<std::string> _threadNames;
+	std::atomic<uint32_t> _nextThread;
+
+	GpuQuerySet _gpuSets[GPU_LATENCY];
+	std::vector<size_t> _gpuOpen;
+
+	FrameProfiler();
+
+	void addEvent(const char* name, Clock::time_point start, Clock::time_point end, uint32_t depth);
+	double toUs(Clock::time_point time) const;
+	uint32_t getThreadIndex();
+	ProfiledFrame& currentFrame();
+	void readGpuQueries(GpuQuerySet& set);
+
+public:
+	static FrameProfiler& get();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	//only call it once a GL context is current on the thread that renders
+	void enableGpuTimers();
+
+	//number of frames kept in the ring buffer, clears the history
+	void setHistory(size_t frames);
+
+	//called by the thread that renders, everything in between belongs to that frame
+	void beginFrame();
+	void endFrame();
+
+	//nested CPU scopes of the calling thread, prefer ProfileScope
+	void beginScope(const char* name);
+	void endScope();
+
+	//adds a scope that was measured somewhere else, like a PhysX zone
+	void addScope(const char* name, Clock::time_point start, Clock::time_point end);
+
+	//nested GPU passes, only from the thread that renders
+	void beginGpuScope(const char* name);
+	void endGpuScope();
+
+	//CPU and GPU scope of a render pass
+	void beginPass(const char* name);
+	void endPass();
+
+	//scopes of the render thread up to maxDepth and all GPU passes, averaged over the last frames
+	//the result lives in the frame arena of the calling thread
+	FrameVector<ProfileSummary> summarize(unsigned int frames, uint32_t maxDepth = 1);
+
+	double getAverageFrameMs(unsigned int frames);
+
+	//writes the history in the Chrome trace event format, open it in chrome://tracing or Perfetto
+	bool exportChromeTrace(const std::string& path);
+};
+
+//measures the CPU time until the end of the enclosing block
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) { FrameProfiler::get().beginScope(name); }
+	~ProfileScope() { FrameProfiler::get().endScope(); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+//measures a render pass on the CPU and the GPU until the end of the enclosing block
+class GpuProfileScope
+{
+private:
+	ProfileScope _cpu;
+
+public:
+	explicit GpuProfileScope(const char* name) : _cpu(name) { FrameProfiler::get().beginGpuScope(name); }
+	~GpuProfileScope() { FrameProfiler::get().endGpuScope(); }
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm\glm.hpp>
+
+
+/*
+View frustum as six planes (xyz = normal pointing inwards, w = distance),
+extracted from a view projection matrix (Gribb/Hartmann).
+*/
+struct Frustum {
+
+	glm::vec4 planes[6];
+
+	Frustum() {}
+
+	explicit Frustum(const glm::mat4& viewProjection) {
+		glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		planes[0] = row3 + row0; // left
+		planes[1] = row3 - row0; // right
+		planes[2] = row3 + row1; // bottom
+		planes[3] = row3 - row1; // top
+		planes[4] = row3 + row2; // near
+		planes[5] = row3 - row2; // far
+
+		for (int i = 0; i < 6; i++) {
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+		}
+	}
+
+	//true if the axis aligned box is at least partially inside
+	bool intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+		for (int i = 0; i < 6; i++) {
+			// the corner that lies furthest along the plane normal
+			glm::vec3 positive = glm::vec3(
+				planes[i].x >= 0.0f ? boxMax.x : boxMin.x,
+				planes[i].y >= 0.0f ? boxMax.y : boxMin.y,
+				planes[i].z >= 0.0f ? boxMax.z : boxMin.z
+			);
+			if (glm::dot(glm::vec3(planes[i]), positive) + planes[i].w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+};
@@ -0,0 +1,44 @@
+#include "GameState.h"
+#include "Utils.h"
+
+
+GameState GameStateMachine::getState() const
+{
+	return _state;
+}
+
+void GameStateMachine::setState(GameState state)
+{
+	if (state == _state)
+		return;
+
+	_state = state;
+	_dirty = true;
+}
+
+bool GameStateMachine::isRunning() const
+{
+	return _state == PSTATE_PLAYING;
+}
+
+void GameStateMachine::invalidate()
+{
+	_dirty = true;
+}
+
+bool GameStateMachine::waitForEvents(double tickSeconds)
+{
+	// a change that is already pending is drawn right away
+	if (!_dirty)
+		glfwWaitEventsTimeout(tickSeconds);
+	else
+		glfwPollEvents();
+
+	double now = glfwGetTime();
+	bool redraw = _dirty || now - _lastRedraw >= tickSeconds;
+	if (redraw) {
+		_dirty = false;
+		_lastRedraw = now;
+	}
+	return redraw;
+}
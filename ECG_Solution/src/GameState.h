@@ -0,0 +1,44 @@
+#pragma once
+
+
+enum GameState {
+
+	//the level is built, nothing runs yet
+	PSTATE_LOADING,
+	PSTATE_PLAYING,
+	PSTATE_PAUSED,
+	PSTATE_GAME_OVER,
+	PSTATE_WON
+};
+
+/*
+The state the game is in and when its screen has to be drawn.
+Only playing renders every frame. All other states wait for input in
+glfwWaitEventsTimeout and redraw their screen only when something changed
+or once per tick, so an idle game uses next to no CPU and GPU.
+The render loop asks every iteration which of the two it has to do, there are
+no loops of their own for the screens.
+*/
+class GameStateMachine
+{
+private:
+	GameState _state = PSTATE_LOADING;
+	//the screen has to be drawn again, set by state changes and by the window
+	bool _dirty = true;
+	double _lastRedraw = 0.0;
+
+public:
+	GameState getState() const;
+
+	//does nothing if the game is in that state already
+	void setState(GameState state);
+
+	//true while the world is simulated and rendered every frame
+	bool isRunning() const;
+
+	//the window was exposed or resized, the screen of an idle state has to be redrawn
+	void invalidate();
+
+	//blocks until an event arrives or the tick is over, returns true if the idle screen has to be drawn
+	bool waitForEvents(double tickSeconds);
+};
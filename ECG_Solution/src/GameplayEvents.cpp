@@ -0,0 +1,136 @@
+#include "GameplayEvents.h"
+
+using namespace physx;
+
+
+static bool isImmovable(PxFilterObjectAttributes attributes)
+{
+	return PxFilterObjectIsKinematic(attributes) || PxGetFilterObjectType(attributes) == PxFilterObjectType::eRIGID_STATIC;
+}
+
+PxFilterFlags gameplayFilterShader(
+	PxFilterObjectAttributes attributes0, PxFilterData filterData0,
+	PxFilterObjectAttributes attributes1, PxFilterData filterData1,
+	PxPairFlags& pairFlags, const void* constantBlock, PxU32 constantBlockSize)
+{
+	PX_UNUSED(constantBlock);
+	PX_UNUSED(constantBlockSize);
+
+	bool report = (filterData0.word0 & filterData1.word1) || (filterData1.word0 & filterData0.word1);
+
+	if (PxFilterObjectIsTrigger(attributes0) || PxFilterObjectIsTrigger(attributes1)) {
+		// a trigger next to a wall is of no interest
+		if (!report)
+			return PxFilterFlag::eSUPPRESS;
+
+		pairFlags = PxPairFlag::eTRIGGER_DEFAULT;
+		return PxFilterFlag::eDEFAULT;
+	}
+
+	// the scene keeps kinematic pairs for the triggers of the patrol enemies and the key,
+	// bodies that can not be pushed have nothing to solve against each other
+	if (isImmovable(attributes0) && isImmovable(attributes1))
+		return PxFilterFlag::eSUPPRESS;
+
+	pairFlags = PxPairFlag::eCONTACT_DEFAULT;
+	if (report) {
+		pairFlags |= PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_TOUCH_LOST;
+	}
+	return PxFilterFlag::eDEFAULT;
+}
+
+
+void GameplayEventCallback::raise(GameplayEventType type, bool begin, PxShape* shape, PxRigidActor* source)
+{
+	std::set<PxShape*>& overlaps = type == PEVENT_PLAYER_HIT ? _hitShapes : _keyShapes;
+
+	// only report changes, a reset in between may already have forgotten the overlap
+	if (begin) {
+		if (!overlaps.insert(shape).second)
+			return;
+	}
+	else if (overlaps.erase(shape) == 0) {
+		return;
+	}
+
+	GameplayEvent event;
+	event.type = type;
+	event.begin = begin;
+	event.source = source;
+	_events.push_back(event);
+}
+
+void GameplayEventCallback::onTrigger(PxTriggerPair* pairs, PxU32 count)
+{
+	for (PxU32 i = 0; i < count; i++) {
+		const PxTriggerPair& pair = pairs[i];
+
+		// a released shape must not be touched anymore, just end its overlap
+		if (pair.flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER)) {
+			if (_hitShapes.count(pair.triggerShape))
+				raise(PEVENT_PLAYER_HIT, false, pair.triggerShape, nullptr);
+			else if (_keyShapes.count(pair.triggerShape))
+				raise(PEVENT_KEY_COLLECTED, false, pair.triggerShape, nullptr);
+			continue;
+		}
+
+		if (!(pair.otherShape->getSimulationFilterData().word0 & PFILTER_PLAYER))
+			continue;
+
+		bool begin = pair.status == PxPairFlag::eNOTIFY_TOUCH_FOUND;
+		PxU32 group = pair.triggerShape->getSimulationFilterData().word0;
+
+		if (group & PFILTER_ENEMY)
+			raise(PEVENT_PLAYER_HIT, begin, pair.triggerShape, pair.triggerActor);
+		else if (group & PFILTER_PICKUP)
+			raise(PEVENT_KEY_COLLECTED, begin, pair.triggerShape, pair.triggerActor);
+	}
+}
+
+void GameplayEventCallback::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs)
+{
+	// touching an enemy body counts as a hit as well
+	for (PxU32 i = 0; i < nbPairs; i++) {
+		const PxContactPair& pair = pairs[i];
+		if (pair.flags & (PxContactPairFlag::eREMOVED_SHAPE_0 | PxContactPairFlag::eREMOVED_SHAPE_1))
+			continue;
+
+		PxU32 group0 = pair.shapes[0]->getSimulationFilterData().word0;
+		PxU32 group1 = pair.shapes[1]->getSimulationFilterData().word0;
+		int enemy = (group0 & PFILTER_ENEMY) && (group1 & PFILTER_PLAYER) ? 0 : ((group1 & PFILTER_ENEMY) && (group0 & PFILTER_PLAYER) ? 1 : -1);
+		if (enemy < 0)
+			continue;
+
+		if (pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND)
+			raise(PEVENT_PLAYER_HIT, true, pair.shapes[enemy], pairHeader.actors[enemy]);
+		else if (pair.events & PxPairFlag::eNOTIFY_TOUCH_LOST)
+			raise(PEVENT_PLAYER_HIT, false, pair.shapes[enemy], pairHeader.actors[enemy]);
+	}
+}
+
+const std::vector<GameplayEvent>& GameplayEventCallback::getEvents()
+{
+	return _events;
+}
+
+void GameplayEventCallback::clearEvents()
+{
+	_events.clear();
+}
+
+bool GameplayEventCallback::isPlayerHit()
+{
+	return !_hitShapes.empty();
+}
+
+bool GameplayEventCallback::isKeyCollected()
+{
+	return !_keyShapes.empty();
+}
+
+void GameplayEventCallback::reset()
+{
+	_hitShapes.clear();
+	_keyShapes.clear();
+	_events.clear();
+}
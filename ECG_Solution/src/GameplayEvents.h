@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include "PxPhysicsAPI.h"
+
+
+//groups for word0 of the simulation filter data, word1 holds the groups a shape wants to hear about
+enum PhysicsFilterGroup {
+
+	PFILTER_PLAYER = 1 << 0,
+	PFILTER_ENEMY = 1 << 1,
+	PFILTER_PICKUP = 1 << 2
+};
+
+enum GameplayEventType {
+
+	PEVENT_PLAYER_HIT,
+	PEVENT_KEY_COLLECTED
+};
+
+//raised when an overlap begins (begin = true) or ends
+struct GameplayEvent {
+
+	GameplayEventType type;
+	bool begin;
+	//actor of the enemy or pickup
+	physx::PxRigidActor* source;
+};
+
+//filter shader of the scene: regular contacts for everything, reports only for pairs whose groups match
+physx::PxFilterFlags gameplayFilterShader(
+	physx::PxFilterObjectAttributes attributes0, physx::PxFilterData filterData0,
+	physx::PxFilterObjectAttributes attributes1, physx::PxFilterData filterData1,
+	physx::PxPairFlags& pairFlags, const void* constantBlock, physx::PxU32 constantBlockSize);
+
+/*
+Receives the trigger and contact reports of the scene during fetchResults and turns
+them into gameplay events. The current overlaps are kept, so asking whether the player
+is hit does not depend on how many enemies or pickups exist.
+*/
+class GameplayEventCallback : public physx::PxSimulationEventCallback
+{
+private:
+	std::vector<GameplayEvent> _events;
+
+	//shapes of enemies and pickups that currently touch the player
+	std::set<physx::PxShape*> _hitShapes;
+	std::set<physx::PxShape*> _keyShapes;
+
+	void raise(GameplayEventType type, bool begin, physx::PxShape* shape, physx::PxRigidActor* source);
+
+public:
+	void onTrigger(physx::PxTriggerPair* pairs, physx::PxU32 count) override;
+	void onContact(const physx::PxContactPairHeader& pairHeader, const physx::PxContactPair* pairs, physx::PxU32 nbPairs) override;
+
+	void onConstraintBreak(physx::PxConstraintInfo*, physx::PxU32) override {}
+	void onWake(physx::PxActor**, physx::PxU32) override {}
+	void onSleep(physx::PxActor**, physx::PxU32) override {}
+	void onAdvance(const physx::PxRigidBody* const*, const physx::PxTransform*, const physx::PxU32) override {}
+
+	//events since the last clearEvents
+	const std::vector<GameplayEvent>& getEvents();
+	void clearEvents();
+
+	bool isPlayerHit();
+	bool isKeyCollected();
+
+	//forgets all overlaps, used when the player is teleported
+	void reset();
+};
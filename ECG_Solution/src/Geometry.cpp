@@ -5,9 +5,11 @@
 */
 
 #include "Geometry.h"
+#include "TransformSystem.h"
+#include "GpuMemory.h"
 
 Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Material> material)
-	: _elements(data.indices.size()), _modelMatrix(modelMatrix), _material(material)
+	: _elements(data.indices.size()), _material(material), _modelMatrix(modelMatrix), _normalMatrix(computeNormalMatrix(modelMatrix))
 {
 	// create VAO
 	glGenVertexArrays(1, &_vao);
@@ -16,7 +18,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Ma
 	// create positions VBO
 	glGenBuffers(1, &_vboPositions);
 	glBindBuffer(GL_ARRAY_BUFFER, _vboPositions);
-	glBufferData(GL_ARRAY_BUFFER, data.positions.size() * sizeof(glm::vec3), data.positions.data(), GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ARRAY_BUFFER, _vboPositions, data.positions.size() * sizeof(glm::vec3), data.positions.data(), GL_STATIC_DRAW);
 
 	// bind positions to location 0
 	glEnableVertexAttribArray(0);
@@ -25,7 +27,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Ma
 	// create normals VBO
 	glGenBuffers(1, &_vboNormals);
 	glBindBuffer(GL_ARRAY_BUFFER, _vboNormals);
-	glBufferData(GL_ARRAY_BUFFER, data.normals.size() * sizeof(glm::vec3), data.normals.data(), GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ARRAY_BUFFER, _vboNormals, data.normals.size() * sizeof(glm::vec3), data.normals.data(), GL_STATIC_DRAW);
 
 	// bind normals to location 1
 	glEnableVertexAttribArray(1);
@@ -34,7 +36,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Ma
 	// create uvs VBO
 	glGenBuffers(1, &_vboUVs);
 	glBindBuffer(GL_ARRAY_BUFFER, _vboUVs);
-	glBufferData(GL_ARRAY_BUFFER, data.uvs.size() * sizeof(glm::vec2), data.uvs.data(), GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ARRAY_BUFFER, _vboUVs, data.uvs.size() * sizeof(glm::vec2), data.uvs.data(), GL_STATIC_DRAW);
 
 	// bind uvs to location 2
 	glEnableVertexAttribArray(2);
@@ -43,7 +45,7 @@ Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Ma
 	// create and bind indices VBO
 	glGenBuffers(1, &_vboIndices);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vboIndices);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ELEMENT_ARRAY_BUFFER, _vboIndices, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
 
 	glBindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -53,10 +55,10 @@ Geometry::Geometry() {}
 
 Geometry::~Geometry()
 {
-	glDeleteBuffers(1, &_vboPositions);
-	glDeleteBuffers(1, &_vboNormals);
-	glDeleteBuffers(1, &_vboUVs);
-	glDeleteBuffers(1, &_vboIndices);
+	gpuDeleteBuffers(1, &_vboPositions);
+	gpuDeleteBuffers(1, &_vboNormals);
+	gpuDeleteBuffers(1, &_vboUVs);
+	gpuDeleteBuffers(1, &_vboIndices);
 	glDeleteVertexArrays(1, &_vao);
 }
 
@@ -66,7 +68,7 @@ void Geometry::draw()
 	shader->use();
 
 	shader->setUniform("modelMatrix", _modelMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(_modelMatrix))));
+	shader->setUniform("normalMatrix", _normalMatrix);
 	_material->setUniforms();
 
 	glBindVertexArray(_vao);
@@ -84,7 +86,7 @@ void Geometry::draw(float time)
 	shader->setUniform("roughness", 0.1f );
 	shader->setUniform("ao", 0.5f);
 	shader->setUniform("modelMatrix", _modelMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(_modelMatrix))));
+	shader->setUniform("normalMatrix", _normalMatrix);
 	_material->setUniforms();
 
 	glBindVertexArray(_vao);
@@ -101,7 +103,7 @@ void Geometry::draw(float time, Shader* shader)
 	shader->setUniform("roughness", 0.1f);
 	shader->setUniform("ao", 0.5f);
 	shader->setUniform("modelMatrix", _modelMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(_modelMatrix))));
+	shader->setUniform("normalMatrix", _normalMatrix);
 	//_material->setUniforms();
 
 	glBindVertexArray(_vao);
@@ -114,7 +116,7 @@ void Geometry::draw(Shader* shader)
 	shader->use();
 	shader->setUniform("lightColor", glm::vec3(0.902f, 0.376f, 0.118f));
 	shader->setUniform("modelMatrix", _modelMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(_modelMatrix))));
+	shader->setUniform("normalMatrix", _normalMatrix);
 	//_material->setUniforms();
 
 	glBindVertexArray(_vao);
@@ -122,6 +124,20 @@ void Geometry::draw(Shader* shader)
 	glBindVertexArray(0);
 }
 
+void Geometry::draw(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix)
+{
+	Shader* shader = _material->getShader();
+	shader->use();
+
+	shader->setUniform("modelMatrix", modelMatrix);
+	shader->setUniform("normalMatrix", normalMatrix);
+	_material->setUniforms();
+
+	glBindVertexArray(_vao);
+	glDrawElements(GL_TRIANGLES, _elements, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+}
+
 glm::mat4 Geometry::getModelMatrix() {
 
 	return _modelMatrix;
@@ -135,16 +151,19 @@ std::shared_ptr<Material> Geometry::getMaterial(){
 
 void Geometry::setModelMatrix(glm::mat4 modelmatrix){
 	_modelMatrix = modelmatrix;
+	_normalMatrix = computeNormalMatrix(_modelMatrix);
 };
 
 void Geometry::transform(glm::mat4 transformation)
 {
 	_modelMatrix = transformation * _modelMatrix;
+	_normalMatrix = computeNormalMatrix(_modelMatrix);
 }
 
 void Geometry::resetModelMatrix()
 {
 	_modelMatrix = glm::mat4(1);
+	_normalMatrix = glm::mat3(1);
 }
 
 
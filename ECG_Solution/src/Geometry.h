@@ -75,6 +75,11 @@ protected:
 	 * Model matrix of the object
 	 */
 	glm::mat4 _modelMatrix;
+
+	/*!
+	 * Normal matrix of the object, recomputed whenever the model matrix changes
+	 */
+	glm::mat3 _normalMatrix;
 	
 public:
 	/*!
@@ -102,6 +107,13 @@ public:
 
 	void Geometry::draw(Shader* shader);
 	void Geometry::draw(float time, Shader* shader);
+
+	/*!
+	 * Draws the object at another place, with the material of the object
+	 * @param modelMatrix: model matrix to draw with instead of the own one
+	 * @param normalMatrix: the matching normal matrix, see computeNormalMatrix
+	 */
+	void draw(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix);
 	/*!
 	 * normal getter
 	 * needed for calculating the objects position
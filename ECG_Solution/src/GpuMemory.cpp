@@ -0,0 +1,143 @@
+#include "GpuMemory.h"
+#include <unordered_map>
+
+
+struct TrackedObject {
+
+	MemorySubsystem subsystem;
+	size_t bytes;
+};
+
+static std::unordered_map<GLuint, TrackedObject> trackedBuffers;
+static std::unordered_map<GLuint, TrackedObject> trackedTextures;
+static std::unordered_map<GLuint, TrackedObject> trackedRenderbuffers;
+
+
+static void track(std::unordered_map<GLuint, TrackedObject>& objects, GLuint handle, MemorySubsystem subsystem, size_t bytes)
+{
+	std::unordered_map<GLuint, TrackedObject>::iterator it = objects.find(handle);
+	if (it != objects.end())
+		MemoryTracker::get().release(it->second.subsystem, PMEM_VRAM, it->second.bytes);
+
+	TrackedObject object;
+	object.subsystem = subsystem;
+	object.bytes = bytes;
+	objects[handle] = object;
+	MemoryTracker::get().allocate(subsystem, PMEM_VRAM, bytes);
+}
+
+static void untrack(std::unordered_map<GLuint, TrackedObject>& objects, GLsizei count, const GLuint* handles)
+{
+	for (GLsizei i = 0; i < count; i++) {
+		std::unordered_map<GLuint, TrackedObject>::iterator it = objects.find(handles[i]);
+		if (it != objects.end()) {
+			MemoryTracker::get().release(it->second.subsystem, PMEM_VRAM, it->second.bytes);
+			objects.erase(it);
+		}
+	}
+}
+
+//drivers may pad, e.g. RGB8 to four bytes, so this is the least the texture needs
+static size_t measureBoundTexture()
+{
+	size_t bytes = 0;
+	for (GLint level = 0; level < 16; level++) {
+		GLint width = 0, height = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if (width == 0 || height == 0)
+			break;
+
+		GLint compressed = GL_FALSE;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+		if (compressed) {
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			bytes += size;
+			continue;
+		}
+
+		const GLenum channels[] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE };
+		GLint bits = 0;
+		for (GLenum channel : channels) {
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, channel, &size);
+			bits += size;
+		}
+		bytes += size_t(width) * size_t(height) * size_t(bits) / 8;
+	}
+	return bytes;
+}
+
+
+void gpuBufferData(MemorySubsystem subsystem, GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage)
+{
+	glBufferData(target, size, data, usage);
+	track(trackedBuffers, buffer, subsystem, size_t(size));
+}
+
+void gpuTrackTexture(MemorySubsystem subsystem, GLuint texture)
+{
+	// the binding of the caller stays as it was
+	GLint previous = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	size_t bytes = measureBoundTexture();
+	glBindTexture(GL_TEXTURE_2D, GLuint(previous));
+
+	track(trackedTextures, texture, subsystem, bytes);
+}
+
+void gpuTrackRenderbuffer(MemorySubsystem subsystem, GLuint renderbuffer)
+{
+	GLint previous = 0;
+	glGetIntegerv(GL_RENDERBUFFER_BINDING, &previous);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+
+	GLint width = 0, height = 0, samples = 0;
+	glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH, &width);
+	glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &height);
+	glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_SAMPLES, &samples);
+
+	const GLenum channels[] = { GL_RENDERBUFFER_RED_SIZE, GL_RENDERBUFFER_GREEN_SIZE, GL_RENDERBUFFER_BLUE_SIZE, GL_RENDERBUFFER_ALPHA_SIZE, GL_RENDERBUFFER_DEPTH_SIZE, GL_RENDERBUFFER_STENCIL_SIZE };
+	GLint bits = 0;
+	for (GLenum channel : channels) {
+		GLint size = 0;
+		glGetRenderbufferParameteriv(GL_RENDERBUFFER, channel, &size);
+		bits += size;
+	}
+	glBindRenderbuffer(GL_RENDERBUFFER, GLuint(previous));
+
+	size_t bytes = size_t(width) * size_t(height) * size_t(bits) / 8 * size_t(samples > 1 ? samples : 1);
+	track(trackedRenderbuffers, renderbuffer, subsystem, bytes);
+}
+
+void gpuDeleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	untrack(trackedBuffers, count, buffers);
+	glDeleteBuffers(count, buffers);
+}
+
+void gpuDeleteTextures(GLsizei count, const GLuint* textures)
+{
+	untrack(trackedTextures, count, textures);
+	glDeleteTextures(count, textures);
+}
+
+void gpuDeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers)
+{
+	untrack(trackedRenderbuffers, count, renderbuffers);
+	glDeleteRenderbuffers(count, renderbuffers);
+}
+
+
+TrackedTexture::TrackedTexture(MemorySubsystem subsystem, std::string file)
+	: Texture(file)
+{
+	gpuTrackTexture(subsystem, _handle);
+}
+
+TrackedTexture::~TrackedTexture()
+{
+	untrack(trackedTextures, 1, &_handle);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <GL/glew.h>
+#include "MemoryTracker.h"
+#include "Texture.h"
+
+
+// GL objects that count their VRAM for a subsystem, only call them from the thread owning the context.
+// The size of an object is replaced whenever it is tracked again, so re-specifying a buffer does not count twice.
+
+//glBufferData on the buffer bound to target, which has to be the given buffer
+void gpuBufferData(MemorySubsystem subsystem, GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+
+//measures every level of a 2D texture after they were uploaded, compressed ones included
+void gpuTrackTexture(MemorySubsystem subsystem, GLuint texture);
+
+//measures a renderbuffer after its storage was allocated
+void gpuTrackRenderbuffer(MemorySubsystem subsystem, GLuint renderbuffer);
+
+//delete the objects and take them out of the accounting
+void gpuDeleteBuffers(GLsizei count, const GLuint* buffers);
+void gpuDeleteTextures(GLsizei count, const GLuint* textures);
+void gpuDeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers);
+
+//a DDS texture of the framework that counts itself, the base class deletes the texture
+class TrackedTexture : public Texture
+{
+public:
+	TrackedTexture(MemorySubsystem subsystem, std::string file);
+	~TrackedTexture();
+};
@@ -0,0 +1,103 @@
+#include "Level.h"
+#include "PhysicsWorld.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+
+static const glm::vec3 HORIZONTAL_WALLS[] = {
+	glm::vec3(5.0f, 0.0f, 10.0f), glm::vec3(-5.0f, 0.0f, 10.0f), glm::vec3(35.0f, 0.0f, 10.0f), glm::vec3(45.0f, 0.0f, 10.0f),
+	glm::vec3(-35.0f, 0.0f, 10.0f), glm::vec3(-45.0f, 0.0f, 20.0f), glm::vec3(-15.0f, 0.0f, 20.0f), glm::vec3(15.0f, 0.0f, 20.0f),
+	glm::vec3(-25.0f, 0.0f, 30.0f), glm::vec3(15.0f, 0.0f, 30.0f), glm::vec3(25.0f, 0.0f, 30.0f), glm::vec3(-35.0f, 0.0f, 40.0f),
+	glm::vec3(-25.0f, 0.0f, 40.0f), glm::vec3(-15.0f, 0.0f, 40.0f), glm::vec3(15.0f, 0.0f, 40.0f), glm::vec3(25.0f, 0.0f, 40.0f),
+	glm::vec3(35.0f, 0.0f, 40.0f), glm::vec3(5.0f, 0.0f, -10.0f), glm::vec3(-35.0f, 0.0f, -10.0f), glm::vec3(35.0f, 0.0f, -10.0f),
+	glm::vec3(45.0f, 0.0f, -10.0f), glm::vec3(-15.0f, 0.0f, -20.0f), glm::vec3(-5.0f, 0.0f, -20.0f), glm::vec3(5.0f, 0.0f, -20.0f),
+	glm::vec3(15.0f, 0.0f, -20.0f), glm::vec3(25.0f, 0.0f, -20.0f), glm::vec3(45.0f, 0.0f, -20.0f), glm::vec3(-35.0f, 0.0f, -30.0f),
+	glm::vec3(-25.0f, 0.0f, -30.0f), glm::vec3(-15.0f, 0.0f, -30.0f), glm::vec3(15.0f, 0.0f, -30.0f), glm::vec3(25.0f, 0.0f, -30.0f),
+	glm::vec3(-35.0f, 0.0f, -40.0f), glm::vec3(-25.0f, 0.0f, -40.0f), glm::vec3(5.0f, 0.0f, -40.0f), glm::vec3(15.0f, 0.0f, -40.0f),
+	glm::vec3(25.0f, 0.0f, -40.0f), glm::vec3(35.0f, 0.0f, -40.0f)
+};
+
+static const glm::vec3 VERTICAL_WALLS[] = {
+	glm::vec3(0.0f, 0.0f, 25.0f), glm::vec3(0.0f, 0.0f, 35.0f), glm::vec3(0.0f, 0.0f, 45.0f), glm::vec3(0.0f, 0.0f, -25.0f),
+	glm::vec3(0.0f, 0.0f, -35.0f), glm::vec3(10.0f, 0.0f, 25.0f), glm::vec3(20.0f, 0.0f, 15.0f), glm::vec3(20.0f, 0.0f, 5.0f),
+	glm::vec3(20.0f, 0.0f, -5.0f), glm::vec3(30.0f, 0.0f, 25.0f), glm::vec3(30.0f, 0.0f, 15.0f), glm::vec3(40.0f, 0.0f, 35.0f),
+	glm::vec3(40.0f, 0.0f, 25.0f), glm::vec3(40.0f, 0.0f, 15.0f), glm::vec3(40.0f, 0.0f, -25.0f), glm::vec3(40.0f, 0.0f, -35.0f),
+	glm::vec3(-10.0f, 0.0f, 35.0f), glm::vec3(-10.0f, 0.0f, 25.0f), glm::vec3(-10.0f, 0.0f, -45.0f), glm::vec3(-10.0f, 0.0f, -35.0f),
+	glm::vec3(-20.0f, 0.0f, -45.0f), glm::vec3(-20.0f, 0.0f, -15.0f), glm::vec3(-20.0f, 0.0f, -5.0f), glm::vec3(-20.0f, 0.0f, 15.0f),
+	glm::vec3(-30.0f, 0.0f, 25.0f), glm::vec3(-30.0f, 0.0f, 15.0f), glm::vec3(-30.0f, 0.0f, -15.0f), glm::vec3(-30.0f, 0.0f, -25.0f),
+	glm::vec3(-40.0f, 0.0f, 35.0f), glm::vec3(-40.0f, 0.0f, 25.0f), glm::vec3(-40.0f, 0.0f, -25.0f), glm::vec3(-40.0f, 0.0f, -35.0f),
+	glm::vec3(-10.0f, 0.0f, -5.0f), glm::vec3(-10.0f, 0.0f, 5.0f), glm::vec3(10.0f, 0.0f, 5.0f), glm::vec3(10.0f, 0.0f, -5.0f)
+};
+
+
+LevelLayout createLevelLayout()
+{
+	LevelLayout level;
+
+	level.horizontalWalls.assign(HORIZONTAL_WALLS, HORIZONTAL_WALLS + sizeof(HORIZONTAL_WALLS) / sizeof(HORIZONTAL_WALLS[0]));
+	level.verticalWalls.assign(VERTICAL_WALLS, VERTICAL_WALLS + sizeof(VERTICAL_WALLS) / sizeof(VERTICAL_WALLS[0]));
+	level.horizontalWallHalfExtents = glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f;
+	level.verticalWallHalfExtents = glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f;
+
+	//Room and stuff
+	float length = 99.f;
+	float width = 99.f;
+
+	// the limits collide a bit thicker than they look
+	LevelBox floor = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(width + 2, 1.f, length + 2), glm::vec3(width + 2, 1.f, length + 2) * 0.5f };
+	LevelBox rightLimit = { glm::vec3(51.4f, 10.25f, 0.0f), glm::vec3(1.f, 50.f, length), glm::vec3(3.f, 50.5f, length) * 0.5f };
+	LevelBox leftLimit = { glm::vec3(-51.4f, 10.25f, 0.0f), glm::vec3(1.f, 50.5f, length), glm::vec3(3.f, 50.5f, length) * 0.5f };
+	LevelBox backLimit = { glm::vec3(0.0f, 10.25f, -51.4f), glm::vec3(width, 50.5f, 1.f), glm::vec3(width, 50.5f, 3.f) * 0.5f };
+	LevelBox frontLimit = { glm::vec3(0.0f, 10.25f, 51.4f), glm::vec3(width, 50.5f, 1.f), glm::vec3(width, 50.5f, 3.f) * 0.5f };
+	level.boundaries.push_back(floor);
+	level.boundaries.push_back(rightLimit);
+	level.boundaries.push_back(leftLimit);
+	level.boundaries.push_back(backLimit);
+	level.boundaries.push_back(frontLimit);
+
+	level.pondRimPosition = glm::vec3(7.0, 1.6f, 7.f);
+	level.pondRimHalfExtents = glm::vec3(1.0f, 1.f, 1.0f);
+
+	level.keyPosition = glm::vec3(45.0f, 3.2f, -25.0f);
+	level.playerHalfExtents = glm::vec3(1.0f, 3.5f, 1.0f) * 0.5f;
+
+	level.chaserPosition = glm::vec3(8.0f, 3.2f, 0.0f);
+	level.chaserRadius = 1.5f;
+
+	LevelPatrol patrol;
+	patrol.position = glm::vec3(-40.0, 7.0, -30.0);
+	patrol.radius = 2.0f;
+	patrol.path.push_back(physx::PxVec3(-15.0, 3.0, -15.0));
+	patrol.path.push_back(physx::PxVec3(-15.0, 3.0, 15.0));
+	patrol.path.push_back(physx::PxVec3(15.0, 3.0, 15.0));
+	patrol.path.push_back(physx::PxVec3(15.0, 3.0, -15.0));
+	level.patrols.push_back(patrol);
+
+	return level;
+}
+
+void addLevelToPhysics(PhysicsWorld& world, const LevelLayout& level, Player& player, bool pondRimAdded)
+{
+	if (!pondRimAdded) {
+		world.addStaticBox(glm::translate(glm::mat4(1.0f), level.pondRimPosition), level.pondRimHalfExtents);
+	}
+
+	world.setKeyPosition(physx::PxVec3(level.keyPosition.x, level.keyPosition.y, level.keyPosition.z));
+
+	for (size_t i = 0; i < level.horizontalWalls.size(); i++) {
+		world.addStaticBox(glm::translate(glm::mat4(1.0f), level.horizontalWalls[i]), level.horizontalWallHalfExtents);
+	}
+	for (size_t i = 0; i < level.verticalWalls.size(); i++) {
+		world.addStaticBox(glm::translate(glm::mat4(1.0f), level.verticalWalls[i]), level.verticalWallHalfExtents);
+	}
+	for (size_t i = 0; i < level.boundaries.size(); i++) {
+		world.addStaticBox(glm::translate(glm::mat4(1.0f), level.boundaries[i].position), level.boundaries[i].halfExtents);
+	}
+	world.buildStaticColliders();
+
+	world.addPlayerToPWorld(player, level.playerHalfExtents);
+	world.addChaser(level.chaserPosition, level.chaserRadius);
+
+	for (size_t i = 0; i < level.patrols.size(); i++) {
+		world.addPatrolEnemy(level.patrols[i].position, level.patrols[i].radius, level.patrols[i].path);
+	}
+}
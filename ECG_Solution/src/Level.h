@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "PxPhysicsAPI.h"
+
+class PhysicsWorld;
+class Player;
+
+
+//a box of the level, size is what is drawn and halfExtents what collides
+struct LevelBox {
+
+	glm::vec3 position;
+	glm::vec3 size;
+	glm::vec3 halfExtents;
+};
+
+struct LevelPatrol {
+
+	glm::vec3 position;
+	float radius;
+	std::vector<physx::PxVec3> path;
+};
+
+/*
+Where everything of the maze is, without anything that needs OpenGL.
+The windowed game creates its models at these places, headless runs only
+build the physics from it, so both simulate exactly the same level.
+*/
+struct LevelLayout {
+
+	//model positions of the 10 x 10 walls along x and along z
+	std::vector<glm::vec3> horizontalWalls;
+	std::vector<glm::vec3> verticalWalls;
+	glm::vec3 horizontalWallHalfExtents;
+	glm::vec3 verticalWallHalfExtents;
+
+	//floor, right, left, back and front limit
+	std::vector<LevelBox> boundaries;
+
+	//the rim of the pond, a cooked mesh in the windowed game if possible, this box otherwise
+	glm::vec3 pondRimPosition;
+	glm::vec3 pondRimHalfExtents;
+
+	glm::vec3 keyPosition;
+	glm::vec3 playerHalfExtents;
+
+	//the ball that chases the player
+	glm::vec3 chaserPosition;
+	float chaserRadius;
+
+	std::vector<LevelPatrol> patrols;
+};
+
+LevelLayout createLevelLayout();
+
+//adds every collider, trigger and enemy of the level to the world, in the same order for every run
+//pondRimAdded skips the box of the pond rim, for when a cooked mesh was added already
+void addLevelToPhysics(PhysicsWorld& world, const LevelLayout& level, Player& player, bool pondRimAdded);
@@ -27,7 +27,7 @@ struct DirectionalLight {
 	 * @param enabled: if the light is enabled
 	 */
 	DirectionalLight(glm::vec3 color, glm::vec3 direction, bool enabled = true)
-		: color(color), direction(glm::normalize(direction)), enabled(enabled)
+		: enabled(enabled), color(color), direction(glm::normalize(direction))
 	{}
 
 	/*!
@@ -66,7 +66,7 @@ struct PointLight {
 	 * @param enabled: if the light is enabled
 	 */
 	PointLight(glm::vec3 color, glm::vec3 position, glm::vec3 attenuation, bool enabled = true)
-		: color(color), position(position), attenuation(attenuation), enabled(enabled)
+		: enabled(enabled), color(color), position(position), attenuation(attenuation)
 	{}
 
 	/*!
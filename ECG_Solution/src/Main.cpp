@@ -21,7 +21,23 @@
 #include "Timer.h"
 #include "Model.h"
 #include <iostream>
-#include "ParticleSystem.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include "ParticleManager.h"
+#include "ThreadPool.h"
+#include "Level.h"
+#include "SessionRecording.h"
+#include "FrameProfiler.h"
+#include "FramePacer.h"
+#include "GameState.h"
+#include "Registry.h"
+#include "SceneSystems.h"
+#include "TransformSystem.h"
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include "GpuMemory.h"
 
 
 /* --------------------------------------------- */
@@ -41,8 +57,16 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void setPerFrameUniforms(Shader* shader, Camera& camera, glm::mat4 projMatrix, DirectionalLight& dirL, PointLight& pointL);
 void processKeyInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double x, double y);
-std::vector<PointLight*> createLights(glm::vec3 flamecolor);
-std::vector<Model*> createWalls(std::shared_ptr<Shader>& shader);
+void window_refresh_callback(GLFWwindow* window);
+void window_focus_callback(GLFWwindow* window, int focused);
+void setGameState(GLFWwindow* window, GameState state);
+void createLights(Registry& scene, glm::vec3 flamecolor);
+void createWalls(Registry& scene, std::shared_ptr<Shader>& shader, const LevelLayout& level);
+Entity createEnemyEntity(Registry& scene, Model* model, size_t body);
+void addLevelEmitters(ParticleManager& particles, Registry& scene, glm::vec3 keyPosition);
+bool initHeadlessWorld(ThreadPool& threadPool, float physicsRate, unsigned int maxSubsteps, unsigned int diagnostics, uint64_t pondRimSource = 0);
+int runReplay(const std::string& path, int engineThreads);
+int runHeadless(unsigned int frames, float seconds, float physicsRate, int engineThreads, unsigned int diagnostics, glm::mat4 projection, HeapGuardMode heapGuardMode);
 void drawTrapsOrLava(std::vector<Geometry*> x, boolean isTrap);
 void drawNormalMapped(Model* model, Shader& shader);
 //unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
@@ -60,9 +84,10 @@ static float _zoom = 6.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-//GameLogic bool
-bool resetGame = false;
-bool isDead = false;
+//GameLogic
+GameStateMachine gameState;
+//seconds between two redraws of a screen that is waiting for input
+const double IDLE_REDRAW_SECONDS = 0.5;
 
 // Initialize camera
 Camera camera(glm::vec3(0.0f, 1.0f, 0.0f));
@@ -91,6 +116,16 @@ unsigned int planeVAO;
 float exposure = 0.5f;
 bool mode = true;
 bool specMode = true;
+//F3 shows the physics step counters
+bool showPhysicsStats = false;
+//F4 shows the frame profiler, F5 writes its history to the trace file
+bool showProfiler = false;
+std::string profilerTraceFile = "frame_trace.json";
+
+//mouse movement of the current frame, applied once per frame so a recording can repeat it exactly
+float mouseDeltaX = 0.0f;
+float mouseDeltaY = 0.0f;
+SessionRecorder recorder;
 
 
 /* --------------------------------------------- */
@@ -112,11 +147,60 @@ int main(int argc, char** argv)
 	lastX = (float)window_width;
 	lastY = (float)window_height;
 	int refresh_rate = reader.GetInteger("window", "refresh_rate", 60);
+	PacingMode pacingMode = parsePacingMode(reader.Get("pacing", "mode", "vsync"));
+	float targetFps = float(reader.GetReal("pacing", "target_fps", 0.0f));
 	bool fullscreen = reader.GetBoolean("window", "fullscreen", false);
 	std::string window_title = reader.Get("window", "title", "Get Out!");
 	float fov = float(reader.GetReal("camera", "fov", 60.0f));
 	float nearZ = float(reader.GetReal("camera", "near", 0.1f));
 	float farZ = float(reader.GetReal("camera", "far", 100.0f));
+	float physicsRate = float(reader.GetReal("physics", "rate", 60.0f));
+	int physicsMaxSubsteps = reader.GetInteger("physics", "max_substeps", 5);
+	int engineThreads = reader.GetInteger("engine", "threads", 0);
+	bool cookedColliders = reader.GetBoolean("physics", "cooked_colliders", true);
+	unsigned int physicsDiagnostics = parsePhysicsDiagnostics(reader.Get("physics", "diagnostics", "none"));
+	std::string physicsCaptureFile = reader.Get("physics", "pvd_file", "physx_capture.pxd2");
+	bool profilerEnabled = reader.GetBoolean("profiler", "enabled", false);
+	int profilerHistory = reader.GetInteger("profiler", "history", 240);
+	profilerTraceFile = reader.Get("profiler", "trace_file", "frame_trace.json");
+	int frameArenaKb = reader.GetInteger("memory", "frame_arena_kb", 1024);
+	HeapGuardMode heapGuardMode = parseHeapGuardMode(reader.Get("memory", "heap_guard", "off"));
+
+	// before any thread allocates from its arena for the first time
+	FrameArena::setDefaultCapacity(size_t(frameArenaKb > 0 ? frameArenaKb : 1) * 1024);
+	parseMemoryBudgets(reader.Get("memory", "ram_budget_mb", ""), PMEM_RAM);
+	parseMemoryBudgets(reader.Get("memory", "vram_budget_mb", ""), PMEM_VRAM);
+
+	// --record <file> writes the input of the session, --replay <file> plays one back without a window
+	// --headless runs the game logic without a window for --frames <n> frames or --seconds <s> seconds
+	std::string recordPath;
+	std::string replayPath;
+	bool headless = false;
+	unsigned int headlessFrames = 0;
+	float headlessSeconds = 0.0f;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--headless")
+			headless = true;
+		else if (i + 1 >= argc)
+			break;
+		else if (argument == "--record")
+			recordPath = argv[++i];
+		else if (argument == "--replay")
+			replayPath = argv[++i];
+		else if (argument == "--frames")
+			headlessFrames = static_cast<unsigned int>(std::atoi(argv[++i]));
+		else if (argument == "--seconds")
+			headlessSeconds = float(std::atof(argv[++i]));
+	}
+
+	if (!replayPath.empty()) {
+		return runReplay(replayPath, engineThreads);
+	}
+	if (headless) {
+		glm::mat4 projection = glm::perspective(glm::radians(fov), (float)window_width / (float)window_height, nearZ, farZ);
+		return runHeadless(headlessFrames, headlessSeconds, physicsRate, engineThreads, physicsDiagnostics, projection, heapGuardMode);
+	}
 
 
 	/* --------------------------------------------- */
@@ -153,6 +237,12 @@ int main(int argc, char** argv)
 	// This function makes the context of the specified window current on the calling thread. 
 	glfwMakeContextCurrent(window);
 
+	// swap interval and frame limiter, the swap interval belongs to the current context
+	FramePacer pacer;
+	pacer.configure(pacingMode, targetFps);
+
+	FrameHeapGuard heapGuard(heapGuardMode);
+
 	// Initialize GLEW
 	glewExperimental = true;
 	GLenum err = glewInit();
@@ -180,8 +270,22 @@ int main(int argc, char** argv)
 
 	//TEXT SHADERS IMPLEMENT LIKE IN SHADER.h
 
-	pWorld->initPhysics();
-	PxScene* pScene = pWorld->getScene();
+	// one pool for physics, particles and everything else that runs in parallel
+	ThreadPool threadPool(engineThreads > 0 ? engineThreads : 0);
+	pWorld->initPhysics(threadPool, physicsDiagnostics, physicsCaptureFile);
+	pWorld->setFixedTimestep(physicsRate > 0.0f ? 1.0f / physicsRate : 0.0f, physicsMaxSubsteps > 0 ? physicsMaxSubsteps : 1);
+
+	// the GL context is current from here on, so the render passes can be timed on the GPU as well
+	FrameProfiler& profiler = FrameProfiler::get();
+	profiler.setHistory(profilerHistory > 0 ? profilerHistory : 1);
+	profiler.enableGpuTimers();
+	profiler.setEnabled(profilerEnabled);
+	showProfiler = profilerEnabled;
+	if (pWorld->getProfiler()) {
+		pWorld->getProfiler()->setSink([](const char* name, PhysicsProfiler::Clock::time_point start, PhysicsProfiler::Clock::time_point end) {
+			FrameProfiler::get().addScope(name, start, end);
+		});
+	}
 
 	if (!initFramework()) {
 		EXIT_WITH_ERROR("Failed to init framework");
@@ -193,6 +297,8 @@ int main(int argc, char** argv)
 	glfwSetMouseButtonCallback(window, mouse_button_callback);
 	glfwSetScrollCallback(window, scroll_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetWindowRefreshCallback(window, window_refresh_callback);
+	glfwSetWindowFocusCallback(window, window_focus_callback);
 
 	// set GL defaults
 	glClearColor(0, 0, 0, 1);
@@ -254,12 +360,12 @@ int main(int argc, char** argv)
 		unsigned int brainSpecularMap = TextureFromFile("lambert2SG_Roughness.png", directory4);
 		*/
 		//Load Textures
-		std::shared_ptr<Texture> wallDiffuse = std::make_shared<Texture>("wall.dds");
-		std::shared_ptr<Texture> wallNormal = std::make_shared<Texture>("Jute_cocomat_pxr128.dds");
-		std::shared_ptr<Texture> wallRoughness = std::make_shared<Texture>("wall.dds");
-		std::shared_ptr<Texture> wallAO = std::make_shared<Texture>("wall.dds");
-		std::shared_ptr<Texture> wallMetallic = std::make_shared<Texture>("wall.dds");
-		std::shared_ptr<Texture> waterDDS = std::make_shared<Texture>("waterTexture.dds");
+		std::shared_ptr<Texture> wallDiffuse = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "wall.dds");
+		std::shared_ptr<Texture> wallNormal = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "Jute_cocomat_pxr128.dds");
+		std::shared_ptr<Texture> wallRoughness = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "wall.dds");
+		std::shared_ptr<Texture> wallAO = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "wall.dds");
+		std::shared_ptr<Texture> wallMetallic = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "wall.dds");
+		std::shared_ptr<Texture> waterDDS = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "waterTexture.dds");
 		/*
 		*/
 
@@ -274,7 +380,7 @@ int main(int argc, char** argv)
 		bloomShader->setUniform("bloomBlur", 1);
 
 		std::shared_ptr<Shader> textureShader = std::make_shared<Shader>("texture.vert", "cook_torrance.frag");
-		std::shared_ptr<Shader> particleShader = std::make_shared<Shader>("particle_system.vert", "particle_system.frag");
+		std::shared_ptr<Shader> particleShader = std::make_shared<Shader>("particle_system_packed.vert", "particle_system.frag");
 		std::shared_ptr<Shader> animationShader = std::make_shared<Shader>("animation.vert", "cook_torranceDublicate.frag");
 		animationShader->use();
 		animationShader->setUniform("diffuseTexture", 0);
@@ -294,16 +400,41 @@ int main(int argc, char** argv)
 			
 		// UI TEXT
 		Text* fps = new Text("FPS: ", glm::vec2(50.0f, 100.0f), 1.f, glm::vec3(1.0f, 0.2f, 0.2f), _characters, *uiShader.get());
+		Text* physicsStats = new Text("", glm::vec2(50.0f, 150.0f), 0.5f, glm::vec3(1.0f, 1.0f, 1.0f), _characters, *uiShader.get());
 		Text* endOfGame = new Text("You died! Game Over!", glm::vec2(window_width / 2.0f - 580, window_height - 300.0f), 2.f, glm::vec3(1, 0, 0), _characters, *uiShader.get());
 		Text* UI_test = new Text("Find the Key to Get Out!", glm::vec2(840.0f, 100.0f), 1.f, glm::vec3(1.0f, 1.0f, 1.0f), _characters, *uiShader.get());
 
+		// one line per scope of the profiler breakdown, top left
+		std::vector<Text*> profilerLines;
+		for (int i = 0; i < 16; i++) {
+			profilerLines.push_back(new Text("", glm::vec2(50.0f, window_height - 60.0f - i * 24.0f), 0.45f, glm::vec3(1.0f, 1.0f, 0.6f), _charactersForCooldown, *uiShader.get()));
+		}
+		// live and peak memory of every subsystem and the total, top right next to the breakdown
+		std::vector<Text*> memoryLines;
+		for (int i = 0; i <= PMEM_SUBSYSTEM_COUNT; i++) {
+			memoryLines.push_back(new Text("", glm::vec2(window_width - 760.0f, window_height - 60.0f - i * 24.0f), 0.45f, glm::vec3(0.6f, 1.0f, 1.0f), _charactersForCooldown, *uiShader.get()));
+		}
+
+		// shown once, the models take a while
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		endOfGame->setColor(glm::vec3(1.0f, 1.0f, 1.0f));
+		endOfGame->setText("*Loading...*");
+		endOfGame->drawText();
+		glfwSwapBuffers(window);
+
 
 		// Loading Models 
 		Model* pond = new Model("assets/objects/pond/pond2.gltf", glm::mat4(1.f), *animationShader.get());
 		pond->setModel(glm::translate(glm::scale(pond->getModel(), glm::vec3(0.5f, 0.5f, 0.5f)), glm::vec3(13.f, 2.0f, 13.f)));
+		// the layout of the maze, the physics is built from it after all models are loaded
+		LevelLayout level = createLevelLayout();
+
 		Model* pondRand = new Model("assets/objects/pond/pondRand.obj", glm::mat4(1.f), *textureShaderNormals.get());
-		pondRand->setModel(glm::translate(glm::scale(pondRand->getModel(), glm::vec3(1.0f, 1.0f, 1.0f)), glm::vec3(7.0, 1.6f, 7.f)));
-		pWorld->addCubeToPWorld(*pondRand, glm::vec3(1.0f, 1.f, 1.0f));
+		pondRand->setModel(glm::translate(glm::scale(pondRand->getModel(), glm::vec3(1.0f, 1.0f, 1.0f)), level.pondRimPosition));
+		// the rim can be walked around exactly with a cooked mesh, the box is the cheap fallback
+		bool pondRimCooked = cookedColliders && pWorld->addMeshToPWorld(*pondRand, PTRIANGLEMESH);
+		// a replay has no models, it finds the cooked rim in the collision cache by this
+		uint64_t pondRimSource = pondRimCooked ? CollisionMeshCache::hashModel(*pondRand, PTRIANGLEMESH) : 0;
 
 
 		
@@ -311,11 +442,8 @@ int main(int argc, char** argv)
 		
 		
 
-		Model* wall = new Model("assets/objects/damaged_wall2/Wall2.obj", glm::mat4(1.f), *textureShaderNormals.get());
-
-		// set Key model and the Position in physics world
-		glm::vec3 keyPosition = glm::vec3(45.0f, 3.2f, -25.0f);
-		pWorld->setKeyPosition(PxVec3(keyPosition.x, keyPosition.y, keyPosition.z));
+		// set Key model, the physics world gets its position with the rest of the level
+		glm::vec3 keyPosition = level.keyPosition;
 		Model* key = new Model("assets/objects/key/key.obj", glm::mat4(1.f), *lightMakerShader.get());
 		key->setModel(glm::translate(key->getModel(), keyPosition));
 
@@ -332,7 +460,7 @@ int main(int argc, char** argv)
 		
 
 		// Dummy Texture
-		std::shared_ptr<Texture> floorTXT = std::make_shared<Texture>("wall.dds");
+		std::shared_ptr<Texture> floorTXT = std::make_shared<TrackedTexture>(PMEM_TEXTURES, "wall.dds");
 
 		// Dummy Materials for logic																					x = ambient, y = diffuse, z = specular		
 		std::shared_ptr<Material> playerMat = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.1f), 8.0f, floorTXT);
@@ -345,8 +473,11 @@ int main(int argc, char** argv)
 		//LIGHTS
 		glm::vec3 lightColor = glm::vec3(0.9f, 0.4f, 0.1f);
 
+		//every object of the level is an entity of the scene
+		Registry scene;
+
 		//currently only works on anim shader
-		std::vector<PointLight*> pointLights = createLights(lightColor);
+		createLights(scene, lightColor);
 		PointLight* tmpPoint = new PointLight(lightColor, glm::vec3(0.f, 9.f, 0.f), glm::vec3(0.1f));
 		player.setLight(*tmpPoint);
 
@@ -356,46 +487,57 @@ int main(int argc, char** argv)
 		float width = 99.f;
 
 		//WALLS
-		std::vector<Model*> walls = createWalls(textureShader);
+		createWalls(scene, textureShader, level);
+
+		for (size_t i = 0; i < level.boundaries.size(); i++) {
+			const LevelBox& box = level.boundaries[i];
+			Entity limit = scene.create();
 
-		Geometry* floor = new Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f)), Geometry::createCubeGeometry(width + 2, 1.f, length + 2), groundMat);
-		Geometry* rightLimit = new Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(51.4f, 10.25f, 0.0f)), Geometry::createCubeGeometry(1.f, 50.f, length), wallMat);
-		Geometry* leftLimit = new Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(-51.4f, 10.25f, 0.0f)), Geometry::createCubeGeometry(1.f, 50.5f, length), wallMat);
-		Geometry* frontLimit = new Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.25f, 51.4f)), Geometry::createCubeGeometry(width, 50.5f, 1.f), wallMat);
-		Geometry* backLimit = new Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.25f, -51.4f)), Geometry::createCubeGeometry(width, 50.5f, 1.f), wallMat);
+			TransformComponent transform;
+			transform.local = glm::translate(glm::mat4(1.0f), box.position);
+			scene.getTransforms().add(limit, transform);
 
-		pWorld->addCubeToPWorld(*floor, glm::vec3(width + 2, 1.f, length + 2) * 0.5f);
-		pWorld->addCubeToPWorld(*rightLimit, glm::vec3(3.f, 50.5f, length) * 0.5f);
-		pWorld->addCubeToPWorld(*leftLimit, glm::vec3(3.f, 50.5f, length) * 0.5f);
-		pWorld->addCubeToPWorld(*backLimit, glm::vec3(width, 50.5f, 3.f) * 0.5f);
-		pWorld->addCubeToPWorld(*frontLimit, glm::vec3(width, 50.5f, 3.f) * 0.5f);
+			RenderComponent render;
+			render.geometry = new Geometry(transform.local, Geometry::createCubeGeometry(box.size.x, box.size.y, box.size.z), i == 0 ? groundMat : wallMat);
+			render.pass = PRENDER_GEOMETRY;
+			scene.getRenders().add(limit, render);
+		}
 
 
 		// ====================================================================================================================
 
-		// PLAYER
-		pWorld->addPlayerToPWorld(player, glm::vec3(1.0f, 3.5f, 1.0f) * 0.5f);
-
+		// PHYSICS, PLAYER and ENEMIES
+		addLevelToPhysics(*pWorld, level, player, pondRimCooked);
 
-		// ENEMIES
+		// all enemies draw the same model, their entities follow the bodies of the physics world
 		Model* brain = new Model("assets/objects/brain/brain2.obj", glm::mat4(1.f), *textureShader.get());
-		brain->setModel(glm::translate(brain->getModel(), glm::vec3(8.0f, 3.2f, 0.0f)));
-		
-
-		//addSphere sets as an enemy if last param is "false"
-		pWorld->addSphereToPWorld(*brain, 1.5f, false);
-
-		std::vector<physx::PxVec3> path1;
-		path1.push_back(physx::PxVec3(-15.0, 3.0, -15.0));
-		path1.push_back(physx::PxVec3(-15.0, 3.0, 15.0));
-		path1.push_back(physx::PxVec3(15.0, 3.0, 15.0));
-		path1.push_back(physx::PxVec3(15.0, 3.0, -15.0));
-		Model* brain_01 = new Model("assets/objects/brain/brain2.obj", glm::mat4(1.f), *textureShader.get());
-		brain_01->setModel(glm::translate(brain_01->getModel(), glm::vec3(-40.0, 7.0, -30.0)));
+		createEnemyEntity(scene, brain, pWorld->getChaserBody());
+		for (size_t i = 0; i < level.patrols.size(); i++) {
+			Entity patrol = createEnemyEntity(scene, brain, pWorld->getPatrolBody(i));
+			PathComponent path;
+			path.patrol = i;
+			scene.getPaths().add(patrol, path);
+		}
 
-		Enemy* enem1 = new Enemy(path1, brain);
+		// every collider is cooked, from here on the meshes only need their GPU buffers
+		std::set<Model*> models = { pond, pondRand, key, armModel, room };
+		const std::vector<RenderComponent>& renderComponents = scene.getRenders().getComponents();
+		for (size_t i = 0; i < renderComponents.size(); i++) {
+			if (renderComponents[i].model)
+				models.insert(renderComponents[i].model);
+		}
+		for (Model* model : models) {
+			model->releaseCpuData();
+		}
 
-		pWorld->addEnemyToPWorld(*brain_01, *enem1, 2.0);
+		if (!recordPath.empty()) {
+			RecordingHeader header;
+			header.physicsRate = physicsRate;
+			header.maxSubsteps = physicsMaxSubsteps > 0 ? physicsMaxSubsteps : 1;
+			header.pondRimSource = pondRimSource;
+			if (!recorder.open(recordPath, header))
+				std::cout << "Could not record to " << recordPath << std::endl;
+		}
 
 
 		double mouse_x, mouse_y;
@@ -405,7 +547,13 @@ int main(int argc, char** argv)
 
 
 		// PARTICLE SYSTEM
-		ParticleSystem particleSystem(particleShader, camera, 1.0f, 0.15f, 100, glm::vec3(0.0f, 1.0f, 0.0f));
+		ParticleManager particleManager(particleShader, camera, threadPool);
+		particleManager.setOcclusionTest([](glm::vec3 from, glm::vec3 to) { return pWorld->isLineBlocked(from, to) != 0; });
+
+		addLevelEmitters(particleManager, scene, keyPosition);
+
+		// what the scene draws this frame, the lists keep their memory
+		DrawList drawList;
 
 		// -----------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -424,6 +572,7 @@ int main(int argc, char** argv)
 		{
 			glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, window_width, window_height, 0, GL_RGBA, GL_FLOAT, NULL);
+			gpuTrackTexture(PMEM_RENDER_TARGETS, colorBuffers[i]);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
@@ -436,6 +585,7 @@ int main(int argc, char** argv)
 		glGenRenderbuffers(1, &rboDepth);
 		glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, window_width, window_height);
+		gpuTrackRenderbuffer(PMEM_RENDER_TARGETS, rboDepth);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
 		// tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
 		unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
@@ -455,6 +605,7 @@ int main(int argc, char** argv)
 			glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
 			glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, window_width, window_height, 0, GL_RGBA, GL_FLOAT, NULL);
+			gpuTrackTexture(PMEM_RENDER_TARGETS, pingpongColorbuffers[i]);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
@@ -468,8 +619,63 @@ int main(int argc, char** argv)
 		// Render Loop
 		// ---------------------------------------
 
+		// the blurred bright parts of the last frame, shown again behind the idle screens
+		unsigned int bloomResult = pingpongColorbuffers[0];
+
+		setGameState(window, PSTATE_PLAYING);
+		lastFrame = static_cast<float>(glfwGetTime());
+
 		while (!glfwWindowShouldClose(window)) {
 
+			if (!gameState.isRunning()) {
+				// nothing moves, sleep until there is input or the screen is due again
+				bool redraw = gameState.waitForEvents(IDLE_REDRAW_SECONDS);
+				processKeyInput(window);
+
+				if (gameState.isRunning()) {
+					// the time spent waiting is not simulated
+					lastFrame = static_cast<float>(glfwGetTime());
+					deltaTime = 0.0f;
+					pacer.restart();
+					heapGuard.restart();
+					continue;
+				}
+				if (!redraw)
+					continue;
+
+				// the last frame of the game, darkened, with the message on top
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				bloomShader->use();
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, bloomResult);
+				bloomShader->setUniform("bloom", bloom);
+				bloomShader->setUniform("exposure", exposure * 0.3f);
+				renderQuad();
+
+				uiShader->use();
+				if (gameState.getState() == PSTATE_GAME_OVER) {
+					endOfGame->setColor(glm::vec3(1, 0, 0));
+					endOfGame->setText("*Game Over! Press Enter to Restart*");
+				}
+				else if (gameState.getState() == PSTATE_WON) {
+					endOfGame->setColor(glm::vec3(0, 1, 0));
+					endOfGame->setText("*You won! Press Enter to restart*");
+				}
+				else {
+					endOfGame->setColor(glm::vec3(1, 1, 1));
+					endOfGame->setText("*Paused, press P to continue*");
+				}
+				endOfGame->drawText();
+				glfwSwapBuffers(window);
+				continue;
+			}
+
+			profiler.beginFrame();
+			FrameArena::beginFrame();
+			heapGuard.beginFrame();
 
 			
 			// Clear backbuffer
@@ -477,31 +683,55 @@ int main(int argc, char** argv)
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 			// Poll events
+			profiler.beginScope("input");
 			glfwPollEvents();
 
+			// GL work that jobs handed back to the thread owning the context
+			threadPool.runMainThreadJobs();
+
 			// Update camera
 			glfwGetCursorPos(window, &mouse_x, &mouse_y);
 			processKeyInput(window);
+			player.ProcessMouseMovement(mouseDeltaX, mouseDeltaY);
+
+			RecordedFrame frame;
+			frame.deltaTime = deltaTime;
+			frame.mouseX = mouseDeltaX;
+			frame.mouseY = mouseDeltaY;
+			frame.movement = static_cast<uint8_t>(pWorld->getQueuedMovement());
+			recorder.record(frame);
+			mouseDeltaX = 0.0f;
+			mouseDeltaY = 0.0f;
+			profiler.endScope();
 
 			Camera* cam = player.getCamera();
 
-			//Update our Dynamic Actors
-			pWorld->updatePlayer(PNOMOVEMENT, deltaTime);
-			pWorld->updateEnemy();
-			pWorld->updateEnemies(deltaTime);
+			//Update our Dynamic Actors in fixed steps, the models are placed in between the last two steps
+			pWorld->step(deltaTime);
+
+			profiler.beginScope("scene update");
+			syncPhysicsTransforms(scene, *pWorld);
+			updateTransforms(scene);
+			buildDrawList(scene, drawList);
+			profiler.endScope();
 
 			//Player Light
+			profiler.beginScope("uniforms");
 			PointLight* tmpPoint2 = player.getLight();
 			setPerFrameUniforms(textureShaderNormals.get(), *cam, cam->getProjectionMatrix(), *tmpPoint2, 0);
 
 			setPerFrameUniforms(textureShader.get(), *cam, cam->getProjectionMatrix(), *tmpPoint2, 4);
 			//set the uniforms for the texture shader
-			for (int i = 0; i < pointLights.size(); i++) {
-				setPerFrameUniforms(textureShader.get(), *cam, cam->getProjectionMatrix(), *pointLights[i], i);
+			std::vector<LightComponent>& lights = scene.getLights().getComponents();
+			for (int i = 0; i < lights.size(); i++) {
+				setPerFrameUniforms(textureShader.get(), *cam, cam->getProjectionMatrix(), lights[i].light, i);
 			}
 
+			profiler.endScope();
+
 			// 1. render scene into floating point framebuffer
 			// -----------------------------------------------
+			profiler.beginPass("scene");
 			glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -512,20 +742,9 @@ int main(int argc, char** argv)
 			// ---------------------------------------
 
 		
-			pWorld->draw();
-
-
-
-
-			brain_01->Draw(brain_01->getModel());
-
-			
-
-			glm::mat4 modelMatrix = key->getModel(); // Your model matrix here
-
-			glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+			drawRenderPass(drawList, PRENDER_GEOMETRY);
 
-			brain->Draw(brain->getModel());
+			drawRenderPass(drawList, PRENDER_LIT);
 
 			// Use the animation shader and set its uniforms
 			animationShader->use();
@@ -533,8 +752,8 @@ int main(int argc, char** argv)
 			animationShader->setUniform("u_time", static_cast<float>(glfwGetTime()));
 			setPerFrameUniforms(animationShader.get(), *cam, cam->getProjectionMatrix(), *tmpPoint2, 0);
 			/*
-			for (int i = 0; i < pointLights.size(); i++) {
-				setPerFrameUniforms(animationShader.get(), *cam, cam->getProjectionMatrix(), *pointLights[i], i);
+			for (int i = 0; i < lights.size(); i++) {
+				setPerFrameUniforms(animationShader.get(), *cam, cam->getProjectionMatrix(), lights[i].light, i);
 			}
 
 			*/
@@ -601,12 +820,7 @@ int main(int argc, char** argv)
 			}
 
 
-			textureShaderNormals->setUniform("model", wall->getModel());
-
-
-			for (size_t i = 0; i < walls.size(); ++i) {
-				drawNormalMapped(walls[i], *textureShaderNormals.get());
-			}
+			drawRenderPass(drawList, PRENDER_NORMAL_MAPPED, textureShaderNormals.get());
 
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, roomDiffuseMap);
@@ -616,21 +830,71 @@ int main(int argc, char** argv)
 			glBindTexture(GL_TEXTURE_2D, roomSpecularMap);
 
 			drawNormalMapped(room, *textureShaderNormals.get());
+			profiler.endPass();
 
 			
 			
 			
 			//HUD
-			float framesPerSec = 1.0f / deltaTime;
-			fps->setText("FPS: " + std::to_string(framesPerSec));
+			profiler.beginPass("hud");
+			// swap to swap times of the last frames, the deviation shows how evenly they are delivered
+			FramePacingStats pacing = pacer.getStats();
+			char pacingText[96];
+			std::snprintf(pacingText, sizeof(pacingText), "FPS: %.1f  %.2f ms +- %.2f, max %.2f", pacing.fps, pacing.averageMs, pacing.deviationMs, pacing.maxMs);
+			fps->setText(pacingText);
 			//fps->setText(std::to_string(mode));
 			fps->drawText();
+			if (showPhysicsStats) {
+				const PhysicsStepCounters& counters = pWorld->getStepCounters();
+				char statsText[192];
+				std::snprintf(statsText, sizeof(statsText), "Physics: %u active, %u/%u pairs touching, %u constraints, simulate %.3f ms, fetch %.3f ms, step %.3f ms",
+					counters.activeDynamics + counters.activeKinematics, counters.touchingPairs, counters.pairs,
+					counters.constraints, counters.simulateMs, counters.fetchMs, counters.stepMs);
+				physicsStats->setText(statsText);
+				physicsStats->drawText();
+			}
+			if (showProfiler) {
+				// averaged over the last second or so, a single frame jumps around too much to read
+				FrameVector<ProfileSummary> summary = profiler.summarize(60);
+				char line[128];
+				std::snprintf(line, sizeof(line), "CPU frame %.2f ms", profiler.getAverageFrameMs(60));
+				profilerLines[0]->setText(line);
+				for (size_t i = 1; i < profilerLines.size(); i++) {
+					if (i - 1 < summary.size()) {
+						const ProfileSummary& entry = summary[i - 1];
+						std::snprintf(line, sizeof(line), "%s%s%s %.3f ms", entry.gpu ? "GPU " : "CPU ", entry.depth > 0 ? "    " : "", entry.name, entry.averageMs);
+						profilerLines[i]->setText(line);
+					}
+					else {
+						profilerLines[i]->setText("");
+					}
+				}
+				for (size_t i = 0; i < profilerLines.size(); i++) {
+					profilerLines[i]->drawText();
+				}
+
+				const MemoryTracker& memory = MemoryTracker::get();
+				for (int i = 0; i <= PMEM_SUBSYSTEM_COUNT; i++) {
+					MemorySubsystem subsystem = MemorySubsystem(i);
+					bool total = i == PMEM_SUBSYSTEM_COUNT;
+					MemoryCounters ram = total ? memory.getTotal(PMEM_RAM) : memory.getCounters(subsystem, PMEM_RAM);
+					MemoryCounters vram = total ? memory.getTotal(PMEM_VRAM) : memory.getCounters(subsystem, PMEM_VRAM);
+					std::snprintf(line, sizeof(line), "%-15s RAM %7.1f (peak %7.1f)  VRAM %7.1f (peak %7.1f) MB", total ? "total" : MemoryTracker::getName(subsystem),
+						ram.live / 1048576.0, ram.peak / 1048576.0, vram.live / 1048576.0, vram.peak / 1048576.0);
+					memoryLines[i]->setText(line);
+					bool overBudget = !total && (memory.isOverBudget(subsystem, PMEM_RAM) || memory.isOverBudget(subsystem, PMEM_VRAM));
+					memoryLines[i]->setColor(overBudget ? glm::vec3(1.0f, 0.3f, 0.3f) : glm::vec3(0.6f, 1.0f, 1.0f));
+					memoryLines[i]->drawText();
+				}
+			}
 			UI_test->drawText();
+			profiler.endPass();
 
 			// PARTICLES
-			particleShader->use();
-			particleSystem.Update(deltaTime, 3, keyPosition);
-			particleSystem.Draw();
+			particleManager.Update(deltaTime);
+			profiler.beginPass("particles");
+			particleManager.Draw();
+			profiler.endPass();
 
 			// Key
 			lightMakerShader->use();
@@ -639,13 +903,14 @@ int main(int argc, char** argv)
 			lightMakerShader->setUniform("lightColor", glm::vec3(5.0f, 5.0f, 5.0f));
 
 			//lightMakerShader->setUniform("lightPos", glm::vec3(10.5f, 10.5f, 10.5f));
-			key->Draw(key->getModel());
+			key->Draw(key->getModel(), key->getNormalMatrix());
 
 
 
 
 			// 2. blur bright fragments with two-pass Gaussian Blur 
 		// --------------------------------------------------
+			profiler.beginPass("bloom blur");
 			bool horizontal = true, first_iteration = true;
 			unsigned int amount = 4;
 			blurShader->use();
@@ -660,47 +925,23 @@ int main(int argc, char** argv)
 					first_iteration = false;
 			}
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			profiler.endPass();
+
+			bloomResult = pingpongColorbuffers[!horizontal];
 
-			//End of game Condition
+			//End of game Condition, this frame is finished and the end screen takes over from the next one
 			if (pWorld->isPlayerHit())
 			{
-					Timer endTimer = Timer();
-					isDead = true;
-					resetGame = false;
-					uiShader->use();
-
-					while (!glfwWindowShouldClose(window) && !resetGame) {
-
-					glfwPollEvents();
-					processKeyInput(window);
-					endOfGame->setColor(glm::vec3(1, 0, 0));
-					endOfGame->setText("*Game Over! Press Enter to Restart*");
-					endOfGame->drawText();
-
-					glfwSwapBuffers(window);
-				}
+				setGameState(window, PSTATE_GAME_OVER);
 			}
 			else if (pWorld->playerFoundKey())
 			{
-				Timer endTimer = Timer();
-				isDead = true;
-				resetGame = false;
-				uiShader->use();
-
-				while (!glfwWindowShouldClose(window) && !resetGame) {
-
-					glfwPollEvents();
-					processKeyInput(window);
-					endOfGame->setColor(glm::vec3(0, 1, 0));
-					endOfGame->setText("*You won! Press Enter to restart*");
-					endOfGame->drawText();
-
-					glfwSwapBuffers(window);
-				}
+				setGameState(window, PSTATE_WON);
 			}
 	
 			// 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
 		// --------------------------------------------------------------------------------------------------------------------------
+			profiler.beginPass("tonemap");
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			bloomShader->use();
 			glActiveTexture(GL_TEXTURE0);
@@ -710,18 +951,54 @@ int main(int argc, char** argv)
 			bloomShader->setUniform("bloom", bloom);
 			bloomShader->setUniform("exposure", exposure);
 			renderQuad();
+			profiler.endPass();
 			//time logic
 			float currentFrame = static_cast<float>(glfwGetTime());
 			deltaTime = currentFrame - lastFrame;
 			lastFrame = currentFrame;
 
-			pScene->simulate(deltaTime);
-			pScene->fetchResults(true);
-
 			// Swap buffers
+			profiler.beginScope("pacing");
+			pacer.waitForNextFrame();
+			profiler.endScope();
+			profiler.beginScope("swap");
 			glfwSwapBuffers(window);
+			pacer.frameSwapped();
+			profiler.endScope();
+
+			heapGuard.endFrame();
+			profiler.endFrame();
+		}
+
+		// the last step still runs on the thread pool
+		pWorld->finishSimulation();
+		pWorld->closeDiagnostics();
+		recorder.close();
+		heapGuard.printSummary();
 
+		// what the report still shows as live after this was never freed by anybody
+		for (Model* model : models) {
+			delete model;
 		}
+		for (size_t i = 0; i < renderComponents.size(); i++) {
+			delete renderComponents[i].geometry;
+		}
+		delete water;
+		delete newWater;
+		Text* texts[] = { fps, physicsStats, endOfGame, UI_test };
+		for (Text* text : texts) {
+			delete text;
+		}
+		for (size_t i = 0; i < profilerLines.size(); i++) {
+			delete profilerLines[i];
+		}
+		for (size_t i = 0; i < memoryLines.size(); i++) {
+			delete memoryLines[i];
+		}
+		gpuDeleteTextures(2, colorBuffers);
+		gpuDeleteTextures(2, pingpongColorbuffers);
+		gpuDeleteRenderbuffers(1, &rboDepth);
+		MemoryTracker::get().printReport(std::cout);
 	}
 
 
@@ -759,7 +1036,7 @@ void renderQuad()
 		glGenBuffers(1, &quadVBO);
 		glBindVertexArray(quadVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+		gpuBufferData(PMEM_RENDER_TARGETS, GL_ARRAY_BUFFER, quadVBO, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 		glEnableVertexAttribArray(1);
@@ -776,6 +1053,7 @@ void renderQuad()
 void drawNormalMapped(Model* model, Shader& shader)
 {
 	shader.setUniform("model", model->getModel());
+	shader.setUniform("normalMatrix", model->getNormalMatrix());
 
 	model->Draw(shader);
 }
@@ -831,9 +1109,26 @@ void setPerFrameUniforms(Shader* shader, Camera& camera, glm::mat4 projMatrix, P
 	shader->setUniform("projMatrix", projMatrix);
 	shader->setUniform("camera_world", player.getCamera()->getPosition());
 
-	shader->setUniform("pointLights[" + std::to_string(lightID) + "].color", pointL.color);
-	shader->setUniform("pointLights[" + std::to_string(lightID) + "].position", pointL.position);
-	shader->setUniform("pointLights[" + std::to_string(lightID) + "].attenuation", pointL.attenuation);
+	// building the names allocates, so they are only looked up the first time a shader sets a light
+	struct PointLightLocations {
+		GLint color, position, attenuation;
+	};
+	static std::map<std::pair<Shader*, int>, PointLightLocations> cache;
+
+	std::pair<Shader*, int> key(shader, lightID);
+	std::map<std::pair<Shader*, int>, PointLightLocations>::iterator it = cache.find(key);
+	if (it == cache.end()) {
+		std::string prefix = "pointLights[" + std::to_string(lightID) + "].";
+		PointLightLocations locations;
+		locations.color = shader->getUni(prefix + "color");
+		locations.position = shader->getUni(prefix + "position");
+		locations.attenuation = shader->getUni(prefix + "attenuation");
+		it = cache.insert(std::make_pair(key, locations)).first;
+	}
+
+	shader->setUniform(it->second.color, pointL.color);
+	shader->setUniform(it->second.position, pointL.position);
+	shader->setUniform(it->second.attenuation, pointL.attenuation);
 }
 
 //draw multiple geometry objects stored in a vector
@@ -859,419 +1154,307 @@ void drawModelVector(Model* model, std::vector<glm::mat4*> x)
 }
 
 
-std::vector<Model*> createWalls(std::shared_ptr<Shader>& shader) {
+void createWalls(Registry& scene, std::shared_ptr<Shader>& shader, const LevelLayout& level) {
 
+	// the colliders come from the level as well, see addLevelToPhysics
+	// all walls of a direction draw the same model, only their transforms differ
 	Model* wall = new Model("assets/objects/damaged_wall2/Wall2.obj", glm::mat4(1.f), *shader.get());
-	//pWorld->addCubeToPWorld(*wall, glm::vec3(10.0f, 5.0f, 1.0f) * 0.5f);
-
-	std::vector<Model*> walls;
-
-
-	//horizontal towards pos 
-	Model* wall2 = new Model(*wall);
-	wall2->setModel(glm::translate(wall2->getModel(), glm::vec3(5.0f, 0.0f, 10.0f)));
-	pWorld->addCubeToPWorld(*wall2, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall2);
-
-	Model* wall3 = new Model(*wall);
-	wall3->setModel(glm::translate(wall3->getModel(), glm::vec3(-5.0f, 0.0f, 10.0f)));
-	pWorld->addCubeToPWorld(*wall3, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall3);
-
-	Model* wall4 = new Model(*wall);
-	wall4->setModel(glm::translate(wall4->getModel(), glm::vec3(35.0f, 0.0f, 10.0f)));
-	pWorld->addCubeToPWorld(*wall4, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall4);
-
-	Model* wall5 = new Model(*wall);
-	wall5->setModel(glm::translate(wall5->getModel(), glm::vec3(45.0f, 0.0f, 10.0f)));
-	pWorld->addCubeToPWorld(*wall5, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall5);
-
-	Model* wall6 = new Model(*wall);
-	wall6->setModel(glm::translate(wall6->getModel(), glm::vec3(-35.0f, 0.0f, 10.0f)));
-	pWorld->addCubeToPWorld(*wall6, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall6);
-
-	Model* wall7 = new Model(*wall);
-	wall7->setModel(glm::translate(wall7->getModel(), glm::vec3(-45.0f, 0.0f, 20.0f)));
-	pWorld->addCubeToPWorld(*wall7, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall7);
-
-	Model* wall8 = new Model(*wall);
-	wall8->setModel(glm::translate(wall8->getModel(), glm::vec3(-15.0f, 0.0f, 20.0f)));
-	pWorld->addCubeToPWorld(*wall8, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall8);
-
-	Model* wall9 = new Model(*wall);
-	wall9->setModel(glm::translate(wall9->getModel(), glm::vec3(15.0f, 0.0f, 20.0f)));
-	pWorld->addCubeToPWorld(*wall9, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall9);
-
-	Model* wall10 = new Model(*wall);
-	wall10->setModel(glm::translate(wall10->getModel(), glm::vec3(-25.0f, 0.0f, 30.0f)));
-	pWorld->addCubeToPWorld(*wall10, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall10);
-
-	Model* wall11 = new Model(*wall);
-	wall11->setModel(glm::translate(wall11->getModel(), glm::vec3(15.0f, 0.0f, 30.0f)));
-	pWorld->addCubeToPWorld(*wall11, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall11);
-
-	Model* wall12 = new Model(*wall);
-	wall12->setModel(glm::translate(wall12->getModel(), glm::vec3(25.0f, 0.0f, 30.0f)));
-	pWorld->addCubeToPWorld(*wall12, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall12);
-
-	Model* wall13 = new Model(*wall);
-	wall13->setModel(glm::translate(wall13->getModel(), glm::vec3(-35.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall13, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall13);
-
-	Model* wall14 = new Model(*wall);
-	wall14->setModel(glm::translate(wall14->getModel(), glm::vec3(-25.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall14, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall14);
-
-	Model* wall15 = new Model(*wall);
-	wall15->setModel(glm::translate(wall15->getModel(), glm::vec3(-15.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall15, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall15);
-
-	Model* wall16 = new Model(*wall);
-	wall16->setModel(glm::translate(wall16->getModel(), glm::vec3(15.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall16, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall16);
-
-	Model* wall17 = new Model(*wall);
-	wall17->setModel(glm::translate(wall17->getModel(), glm::vec3(25.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall17, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall17);
-
-	Model* wall18 = new Model(*wall);
-	wall18->setModel(glm::translate(wall18->getModel(), glm::vec3(35.0f, 0.0f, 40.0f)));
-	pWorld->addCubeToPWorld(*wall18, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall18);
-
-	//horizontal towards neg 
-
-	Model* wall19 = new Model(*wall);
-	wall19->setModel(glm::translate(wall19->getModel(), glm::vec3(5.0f, 0.0f, -10.0f)));
-	pWorld->addCubeToPWorld(*wall19, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall19);
-
-	Model* wall20 = new Model(*wall);
-	wall20->setModel(glm::translate(wall20->getModel(), glm::vec3(-35.0f, 0.0f, -10.0f)));
-	pWorld->addCubeToPWorld(*wall20, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall20);
-
-	Model* wall21 = new Model(*wall);
-	wall21->setModel(glm::translate(wall21->getModel(), glm::vec3(35.0f, 0.0f, -10.0f)));
-	pWorld->addCubeToPWorld(*wall21, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall21);
-
-	Model* wall22 = new Model(*wall);
-	wall22->setModel(glm::translate(wall22->getModel(), glm::vec3(45.0f, 0.0f, -10.0f)));
-	pWorld->addCubeToPWorld(*wall22, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall22);
-
-	Model* wall23 = new Model(*wall);
-	wall23->setModel(glm::translate(wall23->getModel(), glm::vec3(-15.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall23, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall23);
-
-	Model* wall24 = new Model(*wall);
-	wall24->setModel(glm::translate(wall24->getModel(), glm::vec3(-5.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall24, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall24);
-
-	Model* wall25 = new Model(*wall);
-	wall25->setModel(glm::translate(wall25->getModel(), glm::vec3(5.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall25, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall25);
-
-	Model* wall26 = new Model(*wall);
-	wall26->setModel(glm::translate(wall26->getModel(), glm::vec3(15.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall26, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall26);
-
-	Model* wall27 = new Model(*wall);
-	wall27->setModel(glm::translate(wall27->getModel(), glm::vec3(25.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall27, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall27);
-
-	Model* wall28 = new Model(*wall);
-	wall28->setModel(glm::translate(wall28->getModel(), glm::vec3(45.0f, 0.0f, -20.0f)));
-	pWorld->addCubeToPWorld(*wall28, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall28);
-
-	Model* wall29 = new Model(*wall);
-	wall29->setModel(glm::translate(wall29->getModel(), glm::vec3(-35.0f, 0.0f, -30.0f)));
-	pWorld->addCubeToPWorld(*wall29, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall29);
-
-	Model* wall30 = new Model(*wall);
-	wall30->setModel(glm::translate(wall30->getModel(), glm::vec3(-25.0f, 0.0f, -30.0f)));
-	pWorld->addCubeToPWorld(*wall30, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall30);
-
-	Model* wall31 = new Model(*wall);
-	wall31->setModel(glm::translate(wall31->getModel(), glm::vec3(-15.0f, 0.0f, -30.0f)));
-	pWorld->addCubeToPWorld(*wall31, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall31);
-
-	Model* wall32 = new Model(*wall);
-	wall32->setModel(glm::translate(wall32->getModel(), glm::vec3(15.0f, 0.0f, -30.0f)));
-	pWorld->addCubeToPWorld(*wall32, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall32);
-
-	Model* wall33 = new Model(*wall);
-	wall33->setModel(glm::translate(wall33->getModel(), glm::vec3(25.0f, 0.0f, -30.0f)));
-	pWorld->addCubeToPWorld(*wall33, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall33);
-
-	Model* wall34 = new Model(*wall);
-	wall34->setModel(glm::translate(wall34->getModel(), glm::vec3(-35.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall34, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall34);
-
-	Model* wall35 = new Model(*wall);
-	wall35->setModel(glm::translate(wall35->getModel(), glm::vec3(-25.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall35, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall35);
-
-	Model* wall36 = new Model(*wall);
-	wall36->setModel(glm::translate(wall36->getModel(), glm::vec3(5.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall36, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall36);
-
-	Model* wall37 = new Model(*wall);
-	wall37->setModel(glm::translate(wall37->getModel(), glm::vec3(15.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall37, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall37);
-
-
-	Model* wall38 = new Model(*wall);
-	wall38->setModel(glm::translate(wall38->getModel(), glm::vec3(25.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall38, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall38);
-
-	Model* wall39 = new Model(*wall);
-	wall39->setModel(glm::translate(wall39->getModel(), glm::vec3(35.0f, 0.0f, -40.0f)));
-	pWorld->addCubeToPWorld(*wall39, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-	walls.push_back(wall39);
-
-	//vertical
-
 	Model* wallVert = new Model("assets/objects/damaged_wall/damagedWallVertical.obj", glm::mat4(1.f), *shader.get());
-	//pWorld->addCubeToPWorld(*wallVert, glm::vec3(10.0f, 10.0f, 1.0f) * 0.5f);
-
-	Model* wall40 = new Model(*wallVert);
-	wall40->setModel(glm::translate(wall40->getModel(), glm::vec3(0.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall40, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall40);
-
-	Model* wall41 = new Model(*wallVert);
-	wall41->setModel(glm::translate(wall41->getModel(), glm::vec3(0.0f, 0.0f, 35.0f)));
-	pWorld->addCubeToPWorld(*wall41, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall41);
-
-	Model* wall42 = new Model(*wallVert);
-	wall42->setModel(glm::translate(wall42->getModel(), glm::vec3(0.0f, 0.0f, 45.0f)));
-	pWorld->addCubeToPWorld(*wall42, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall42);
-
-
-	Model* wall43 = new Model(*wallVert);
-	wall43->setModel(glm::translate(wall43->getModel(), glm::vec3(0.0f, 0.0f, -25.0f)));
-	pWorld->addCubeToPWorld(*wall43, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall43);
-
-	Model* wall44 = new Model(*wallVert);
-	wall44->setModel(glm::translate(wall44->getModel(), glm::vec3(0.0f, 0.0f, -35.0f)));
-	pWorld->addCubeToPWorld(*wall44, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall44);
-
-	Model* wall45 = new Model(*wallVert);
-	wall45->setModel(glm::translate(wall45->getModel(), glm::vec3(10.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall45, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall45);
-
-	Model* wall46 = new Model(*wallVert);
-	wall46->setModel(glm::translate(wall46->getModel(), glm::vec3(20.0f, 0.0f, 15.0f)));
-	pWorld->addCubeToPWorld(*wall46, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall46);
-
-	Model* wall47 = new Model(*wallVert);
-	wall47->setModel(glm::translate(wall47->getModel(), glm::vec3(20.0f, 0.0f, 5.0f)));
-	pWorld->addCubeToPWorld(*wall47, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall47);
-
-	Model* wall48 = new Model(*wallVert);
-	wall48->setModel(glm::translate(wall48->getModel(), glm::vec3(20.0f, 0.0f, -5.0f)));
-	pWorld->addCubeToPWorld(*wall48, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall48);
-
-	Model* wall49 = new Model(*wallVert);
-	wall49->setModel(glm::translate(wall49->getModel(), glm::vec3(30.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall49, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall49);
-
-	Model* wall50 = new Model(*wallVert);
-	wall50->setModel(glm::translate(wall50->getModel(), glm::vec3(30.0f, 0.0f, 15.0f)));
-	pWorld->addCubeToPWorld(*wall50, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall50);
-
-	Model* wall51 = new Model(*wallVert);
-	wall51->setModel(glm::translate(wall51->getModel(), glm::vec3(40.0f, 0.0f, 35.0f)));
-	pWorld->addCubeToPWorld(*wall51, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall51);
-
-	Model* wall52 = new Model(*wallVert);
-	wall52->setModel(glm::translate(wall52->getModel(), glm::vec3(40.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall52, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall52);
-
-	Model* wall53 = new Model(*wallVert);
-	wall53->setModel(glm::translate(wall53->getModel(), glm::vec3(40.0f, 0.0f, 15.0f)));
-	pWorld->addCubeToPWorld(*wall53, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall53);
-
-	Model* wall54 = new Model(*wallVert);
-	wall54->setModel(glm::translate(wall54->getModel(), glm::vec3(40.0f, 0.0f, -25.0f)));
-	pWorld->addCubeToPWorld(*wall54, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall54);
-
-	Model* wall55 = new Model(*wallVert);
-	wall55->setModel(glm::translate(wall55->getModel(), glm::vec3(40.0f, 0.0f, -35.0f)));
-	pWorld->addCubeToPWorld(*wall55, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall55);
-
-	//vert towards neg
-	Model* wall56 = new Model(*wallVert);
-	wall56->setModel(glm::translate(wall56->getModel(), glm::vec3(-10.0f, 0.0f, 35.0f)));
-	pWorld->addCubeToPWorld(*wall56, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall56);
-
-	Model* wall57 = new Model(*wallVert);
-	wall57->setModel(glm::translate(wall57->getModel(), glm::vec3(-10.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall57, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall57);
-
-	Model* wall58 = new Model(*wallVert);
-	wall58->setModel(glm::translate(wall58->getModel(), glm::vec3(-10.0f, 0.0f, -45.0f)));
-	pWorld->addCubeToPWorld(*wall58, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall58);
-
-	Model* wall59 = new Model(*wallVert);
-	wall59->setModel(glm::translate(wall59->getModel(), glm::vec3(-10.0f, 0.0f, -35.0f)));
-	pWorld->addCubeToPWorld(*wall59, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall59);
-
-	Model* wall60 = new Model(*wallVert);
-	wall60->setModel(glm::translate(wall60->getModel(), glm::vec3(-20.0f, 0.0f, -45.0f)));
-	pWorld->addCubeToPWorld(*wall60, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall60);
-
-	Model* wall61 = new Model(*wallVert);
-	wall61->setModel(glm::translate(wall61->getModel(), glm::vec3(-20.0f, 0.0f, -15.0f)));
-	pWorld->addCubeToPWorld(*wall61, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall61);
-
-	Model* wall62 = new Model(*wallVert);
-	wall62->setModel(glm::translate(wall62->getModel(), glm::vec3(-20.0f, 0.0f, -5.0f)));
-	pWorld->addCubeToPWorld(*wall62, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall62);
-
-	Model* wall63 = new Model(*wallVert);
-	wall63->setModel(glm::translate(wall63->getModel(), glm::vec3(-20.0f, 0.0f, 15.0f)));
-	pWorld->addCubeToPWorld(*wall63, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall63);
-
-	Model* wall64 = new Model(*wallVert);
-	wall64->setModel(glm::translate(wall64->getModel(), glm::vec3(-30.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall64, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall64);
-
-	Model* wall65 = new Model(*wallVert);
-	wall65->setModel(glm::translate(wall65->getModel(), glm::vec3(-30.0f, 0.0f, 15.0f)));
-	pWorld->addCubeToPWorld(*wall65, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall65);
-
-	Model* wall66 = new Model(*wallVert);
-	wall66->setModel(glm::translate(wall66->getModel(), glm::vec3(-30.0f, 0.0f, -15.0f)));
-	pWorld->addCubeToPWorld(*wall66, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall66);
-
-	Model* wall67 = new Model(*wallVert);
-	wall67->setModel(glm::translate(wall67->getModel(), glm::vec3(-30.0f, 0.0f, -25.0f)));
-	pWorld->addCubeToPWorld(*wall67, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall67);
-
-	Model* wall68 = new Model(*wallVert);
-	wall68->setModel(glm::translate(wall68->getModel(), glm::vec3(-40.0f, 0.0f, 35.0f)));
-	pWorld->addCubeToPWorld(*wall68, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall68);
-
-	Model* wall69 = new Model(*wallVert);
-	wall69->setModel(glm::translate(wall69->getModel(), glm::vec3(-40.0f, 0.0f, 25.0f)));
-	pWorld->addCubeToPWorld(*wall69, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall69);
-
-	Model* wall70 = new Model(*wallVert);
-	wall70->setModel(glm::translate(wall70->getModel(), glm::vec3(-40.0f, 0.0f, -25.0f)));
-	pWorld->addCubeToPWorld(*wall70, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall70);
-
-	Model* wall71 = new Model(*wallVert);
-	wall71->setModel(glm::translate(wall71->getModel(), glm::vec3(-40.0f, 0.0f, -35.0f)));
-	pWorld->addCubeToPWorld(*wall71, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall71);
-
-	Model* wall72 = new Model(*wallVert);
-	wall72->setModel(glm::translate(wall72->getModel(), glm::vec3(-10.0f, 0.0f, -5.0f)));
-	pWorld->addCubeToPWorld(*wall72, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall72);
-
-	Model* wall73 = new Model(*wallVert);
-	wall73->setModel(glm::translate(wall73->getModel(), glm::vec3(-10.0f, 0.0f, 5.0f)));
-	pWorld->addCubeToPWorld(*wall73, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall73);
-
-	Model* wall74 = new Model(*wallVert);
-	wall74->setModel(glm::translate(wall74->getModel(), glm::vec3(10.0f, 0.0f, 5.0f)));
-	pWorld->addCubeToPWorld(*wall74, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall74);
-
-	Model* wall75 = new Model(*wallVert);
-	wall75->setModel(glm::translate(wall75->getModel(), glm::vec3(10.0f, 0.0f, -5.0f)));
-	pWorld->addCubeToPWorld(*wall75, glm::vec3(1.0f, 10.0f, 10.0f) * 0.5f);
-	walls.push_back(wall75);
-
-	return walls;
+
+	RenderComponent horizontal;
+	horizontal.model = wall;
+	horizontal.pass = PRENDER_NORMAL_MAPPED;
+
+	RenderComponent vertical;
+	vertical.model = wallVert;
+	vertical.pass = PRENDER_NORMAL_MAPPED;
+
+	for (size_t i = 0; i < level.horizontalWalls.size(); i++) {
+		Entity entity = scene.create();
+		TransformComponent transform;
+		transform.local = glm::translate(glm::mat4(1.0f), level.horizontalWalls[i]);
+		scene.getTransforms().add(entity, transform);
+		scene.getRenders().add(entity, horizontal);
+	}
+
+	for (size_t i = 0; i < level.verticalWalls.size(); i++) {
+		Entity entity = scene.create();
+		TransformComponent transform;
+		transform.local = glm::translate(glm::mat4(1.0f), level.verticalWalls[i]);
+		scene.getTransforms().add(entity, transform);
+		scene.getRenders().add(entity, vertical);
+	}
+}
+
+
+//an enemy drawn at the render pose of a physics body
+Entity createEnemyEntity(Registry& scene, Model* model, size_t body)
+{
+	Entity enemy = scene.create();
+
+	TransformComponent transform;
+	transform.local = pWorld->getRenderPoses()[body];
+	scene.getTransforms().add(enemy, transform);
+
+	RenderComponent render;
+	render.model = model;
+	render.pass = PRENDER_LIT;
+	scene.getRenders().add(enemy, render);
+
+	PhysicsComponent physics;
+	physics.body = body;
+	scene.getPhysics().add(enemy, physics);
+	return enemy;
+}
+
+
+//the emitters of the level, they only need GL once they are drawn
+void addLevelEmitters(ParticleManager& particles, Registry& scene, glm::vec3 keyPosition)
+{
+	EmitterSettings keyEmitter;
+	keyEmitter.position = keyPosition + glm::vec3(0.0f, 1.0f, 0.0f);
+
+	Entity sparkle = scene.create();
+	TransformComponent transform;
+	transform.local = glm::translate(glm::mat4(1.0f), keyEmitter.position);
+	scene.getTransforms().add(sparkle, transform);
+	EmitterComponent emitter;
+	emitter.emitter = particles.addEmitter(keyEmitter);
+	scene.getEmitters().add(sparkle, emitter);
+
+	// one flame per torch, on the entity of its light
+	ComponentPool<LightComponent>& torches = scene.getLights();
+	for (size_t i = 0; i < torches.size(); i++) {
+		EmitterSettings torchEmitter;
+		torchEmitter.position = torches.getComponents()[i].light.position;
+		torchEmitter.offsetFactor = 0.2f;
+		torchEmitter.size = 0.3f;
+		torchEmitter.amount = 150;
+		torchEmitter.spread = 0.4f;
+		torchEmitter.life = 1.0f;
+		torchEmitter.r = 255;
+		torchEmitter.g = 110;
+		torchEmitter.b = 25;
+		torchEmitter.a = 180;
+		torchEmitter.blendMode = PBLEND_ADDITIVE;
+
+		EmitterComponent flame;
+		flame.emitter = particles.addEmitter(torchEmitter);
+		scene.getEmitters().add(torches.getEntities()[i], flame);
+	}
+}
 
 
+//physics, player and enemies of the level without any model
+//the pond rim is its box, or the cooked mesh with the given source hash from the collision cache
+//returns false if that mesh is not in the cache
+bool initHeadlessWorld(ThreadPool& threadPool, float physicsRate, unsigned int maxSubsteps, unsigned int diagnostics, uint64_t pondRimSource)
+{
+	pWorld->initPhysics(threadPool, diagnostics);
+	pWorld->setFixedTimestep(physicsRate > 0.0f ? 1.0f / physicsRate : 0.0f, maxSubsteps > 0 ? maxSubsteps : 1);
+
+	LevelLayout level = createLevelLayout();
+	bool pondRimCooked = false;
+	if (pondRimSource != 0) {
+		// the same transform the rim model gets when the level is loaded with models
+		pondRimCooked = pWorld->addCachedMeshToPWorld(pondRimSource, glm::translate(glm::mat4(1.0f), level.pondRimPosition));
+		if (!pondRimCooked)
+			return false;
+	}
+	addLevelToPhysics(*pWorld, level, player, pondRimCooked);
+	return true;
 }
-//create all the lights for the torches
-std::vector<PointLight*> createLights(glm::vec3 flamecolor)
+
+
+//time one system took per frame
+struct SystemTiming {
+
+	const char* name;
+	double totalMs = 0.0;
+	float maxMs = 0.0f;
+
+	SystemTiming(const char* systemName) : name(systemName) {}
+
+	void add(float ms) {
+		totalMs += ms;
+		maxMs = ms > maxMs ? ms : maxMs;
+	}
+};
+
+
+//runs the game logic without window or GL for a number of frames or seconds and prints how long every system took
+//the player walks forward and slowly turns, so it keeps running into walls and enemies
+//it needs no GPU or display, but it is still a mode of the Windows binary: PhysX and the framework library
+//only come as Win32 libraries, so a Linux build of the game logic is out of scope
+int runHeadless(unsigned int frames, float seconds, float physicsRate, int engineThreads, unsigned int diagnostics, glm::mat4 projection, HeapGuardMode heapGuardMode)
 {
-	std::vector<PointLight*> lights;
+	if (frames == 0 && seconds <= 0.0f) {
+		frames = 3600;
+	}
+
+	// one frame per physics step, then every counter of the step belongs to exactly one frame
+	float frameTime = physicsRate > 0.0f ? 1.0f / physicsRate : 1.0f / 60.0f;
+
+	ThreadPool threadPool(engineThreads > 0 ? engineThreads : 0);
+	if (!initHeadlessWorld(threadPool, 1.0f / frameTime, 1, diagnostics | PDIAG_COUNTERS)) {
+		std::cout << "Could not build the level for the headless run" << std::endl;
+		pWorld->closeDiagnostics();
+		return EXIT_FAILURE;
+	}
+	player.getCamera()->setProjectionMatrix(projection);
+
+	// the shader is only used by Draw
+	std::shared_ptr<Shader> noShader;
+	ParticleManager particleManager(noShader, camera, threadPool);
+	particleManager.setOcclusionTest([](glm::vec3 from, glm::vec3 to) { return pWorld->isLineBlocked(from, to) != 0; });
+	Registry scene;
+	createLights(scene, glm::vec3(1.0f));
+	addLevelEmitters(particleManager, scene, createLevelLayout().keyPosition);
+
+	SystemTiming frameTiming("frame");
+	SystemTiming inputTiming("input");
+	SystemTiming physicsTiming("physics step");
+	SystemTiming gameplayTiming("  player and enemies");
+	SystemTiming simulateTiming("  simulate");
+	SystemTiming fetchTiming("  fetch");
+	SystemTiming particleTiming("particles");
+
+	std::cout << "Headless run on " << threadPool.getThreadCount() << " threads, "
+		<< (frames > 0 ? std::to_string(frames) + " frames" : std::to_string(seconds) + " seconds") << std::endl;
+
+	Timer runTimer;
+	unsigned int frame = 0;
+	unsigned int steps = 0;
+	unsigned int resets = 0;
+	FrameHeapGuard heapGuard(heapGuardMode);
+	while (frames > 0 ? frame < frames : runTimer.Duration() < seconds) {
+		FrameArena::beginFrame();
+		heapGuard.beginFrame();
+		Timer frameTimer;
+
+		Timer systemTimer;
+		player.ProcessMouseMovement(2.0f, 0.0f);
+		pWorld->queueMovement(PFORWARD);
+		inputTiming.add(systemTimer.Duration() * 1000.0f);
+
+		systemTimer.Reset();
+		steps += pWorld->step(frameTime);
+		physicsTiming.add(systemTimer.Duration() * 1000.0f);
+
+		const PhysicsStepCounters& counters = pWorld->getStepCounters();
+		gameplayTiming.add(counters.gameplayMs);
+		simulateTiming.add(counters.simulateMs);
+		fetchTiming.add(counters.fetchMs);
+
+		bool reset = pWorld->isPlayerHit() || pWorld->playerFoundKey();
+		if (reset) {
+			pWorld->resetGame();
+			resets++;
+		}
+
+		systemTimer.Reset();
+		particleManager.Update(frameTime);
+		particleTiming.add(systemTimer.Duration() * 1000.0f);
+
+		frameTiming.add(frameTimer.Duration() * 1000.0f);
+		frame++;
+
+		heapGuard.endFrame();
+		// a reset is a level change, the frames after it may fill caches again
+		if (reset)
+			heapGuard.restart();
+	}
+	pWorld->finishSimulation();
+	float wallSeconds = runTimer.Duration();
+
+	std::cout << frame << " frames, " << steps << " physics steps, " << resets << " resets in " << wallSeconds << " s" << std::endl;
+	std::cout << "system                 avg ms    max ms  total ms" << std::endl;
+	SystemTiming* timings[] = { &frameTiming, &inputTiming, &physicsTiming, &gameplayTiming, &simulateTiming, &fetchTiming, &particleTiming };
+	for (SystemTiming* timing : timings) {
+		std::printf("%-20s %9.4f %9.4f %9.1f\n", timing->name, frame > 0 ? timing->totalMs / frame : 0.0, timing->maxMs, timing->totalMs);
+	}
+
+	ParticleStats particles = particleManager.getStats();
+	std::cout << "Particles: " << particles.alive << " alive of " << particles.capacity << ", " << particleManager.getVisibleEmitterCount()
+		<< " of " << particleManager.getEmitterCount() << " emitters visible" << std::endl;
+
+	heapGuard.printSummary();
+	MemoryTracker::get().printReport(std::cout);
+
+	pWorld->closeDiagnostics();
+	return EXIT_SUCCESS;
+}
 
-	PointLight* tmpPoint = new PointLight(flamecolor, glm::vec3(0.0f, 5.f, 0.0f), glm::vec3(0.001f));
-	lights.push_back(tmpPoint);
 
-	PointLight* tmpPoint1 = new PointLight(flamecolor, glm::vec3(-46.5f, 5.f, 46.5f), glm::vec3(0.001f));
-	lights.push_back(tmpPoint1);
+//plays a recording back without window or GL, as fast as possible, and prints how long it took
+int runReplay(const std::string& path, int engineThreads)
+{
+	RecordingHeader header;
+	std::vector<RecordedFrame> frames;
+	if (!loadRecording(path, header, frames)) {
+		std::cout << "Could not read the recording " << path << std::endl;
+		return EXIT_FAILURE;
+	}
 
+	// without models there is nothing to cook the pond rim from, colliding with its box instead would not reproduce the session
+	ThreadPool threadPool(engineThreads > 0 ? engineThreads : 0);
+	if (!initHeadlessWorld(threadPool, header.physicsRate, header.maxSubsteps, PDIAG_NONE, header.pondRimSource)) {
+		std::printf("The recording used the cooked pond rim %016llx, which is not in the collision cache, run the game once to cook it\n",
+			static_cast<unsigned long long>(header.pondRimSource));
+		pWorld->closeDiagnostics();
+		return EXIT_FAILURE;
+	}
 
-	PointLight* tmpPoint2 = new PointLight(flamecolor, glm::vec3(46.5f, 5.f, 46.5f), glm::vec3(0.001f));
-	lights.push_back(tmpPoint2);
+	Timer replayTimer;
+	unsigned int steps = 0;
+	for (size_t i = 0; i < frames.size(); i++) {
+		const RecordedFrame& frame = frames[i];
 
-	PointLight* tmpPoint3 = new PointLight(flamecolor, glm::vec3(-46.5f, 5.f, -46.5f), glm::vec3(0.001f));
-	lights.push_back(tmpPoint3);
+		if (frame.flags & PRECORD_RESET) {
+			pWorld->resetGame();
+		}
+		player.ProcessMouseMovement(frame.mouseX, frame.mouseY);
+		for (int movement = PFORWARD; movement <= PSPRINT; movement++) {
+			if (frame.movement & (1u << movement)) {
+				pWorld->queueMovement(static_cast<Movement>(movement));
+			}
+		}
+		steps += pWorld->step(frame.deltaTime);
+	}
+	pWorld->finishSimulation();
+	float seconds = replayTimer.Duration();
 
+	// the same recording has to end at the same place every time
+	glm::vec3 position = player.getCamera()->getPosition();
+	std::cout << "Replayed " << frames.size() << " frames, " << steps << " physics steps in " << seconds * 1000.0f << " ms ("
+		<< (frames.empty() ? 0.0f : seconds * 1000.0f / frames.size()) << " ms per frame)" << std::endl;
+	std::cout << "Final player position " << glm::to_string(position) << ", hit " << (pWorld->isPlayerHit() ? "yes" : "no")
+		<< ", key " << (pWorld->playerFoundKey() ? "yes" : "no") << std::endl;
 
-	return lights;
+	pWorld->closeDiagnostics();
+	return EXIT_SUCCESS;
+}
+//create all the lights for the torches, one entity per torch
+void createLights(Registry& scene, glm::vec3 flamecolor)
+{
+	const glm::vec3 positions[] = {
+		glm::vec3(0.0f, 5.f, 0.0f),
+		glm::vec3(-46.5f, 5.f, 46.5f),
+		glm::vec3(46.5f, 5.f, 46.5f),
+		glm::vec3(-46.5f, 5.f, -46.5f)
+	};
+
+	for (const glm::vec3& position : positions) {
+		Entity torch = scene.create();
+
+		TransformComponent transform;
+		transform.local = glm::translate(glm::mat4(1.0f), position);
+		scene.getTransforms().add(torch, transform);
+
+		LightComponent light;
+		light.light = PointLight(flamecolor, position, glm::vec3(0.001f));
+		scene.getLights().add(torch, light);
+	}
 }
 
 //processes all key inputs
@@ -1284,11 +1467,12 @@ void processKeyInput(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS)
 	{
 
-		if (isDead)
+		GameState state = gameState.getState();
+		if (state == PSTATE_GAME_OVER || state == PSTATE_WON)
 		{
 			pWorld->resetGame();
-			resetGame = true;
-			isDead = false;
+			recorder.addFlags(PRECORD_RESET);
+			setGameState(window, PSTATE_PLAYING);
 		}
 	}
 
@@ -1345,27 +1529,27 @@ void processKeyInput(GLFWwindow* window)
 		exposure += 0.1f;
 	}
 
-	if (!isDead) {
+	if (gameState.isRunning()) {
 
 		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 		{
-			pWorld->updatePlayer(PFORWARD, deltaTime);
+			pWorld->queueMovement(PFORWARD);
 		}
 		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
 		{
-			pWorld->updatePlayer(PBACKWARD, deltaTime);
+			pWorld->queueMovement(PBACKWARD);
 		}
 		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
 		{
-			pWorld->updatePlayer(PLEFT, deltaTime);
+			pWorld->queueMovement(PLEFT);
 		}
 		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
 		{
-			pWorld->updatePlayer(PRIGHT, deltaTime);
+			pWorld->queueMovement(PRIGHT);
 		}
 		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
 		{
-			pWorld->updatePlayer(PJUMP, deltaTime);
+			pWorld->queueMovement(PJUMP);
 		}
 
 
@@ -1391,7 +1575,39 @@ void mouse_callback(GLFWwindow* window, double x, double y)
 	lastX = xpos;
 	lastY = ypos;
 
-	player.ProcessMouseMovement(xoffset, yoffset);
+	// applied once per frame in the render loop
+	mouseDeltaX += xoffset;
+	mouseDeltaY += yoffset;
+}
+
+//the window was uncovered or resized, an idle screen has to be drawn again
+void window_refresh_callback(GLFWwindow* window)
+{
+	gameState.invalidate();
+}
+
+//a game that loses the focus is paused, so it does not run on in the background
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+	if (!focused && gameState.getState() == PSTATE_PLAYING)
+		setGameState(window, PSTATE_PAUSED);
+}
+
+//switches the state and gives the mouse back while the game is not running
+void setGameState(GLFWwindow* window, GameState state)
+{
+	gameState.setState(state);
+
+	if (state == PSTATE_PLAYING) {
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		// the cursor moved freely in the meantime, that must not turn the camera
+		firstMouse = true;
+		mouseDeltaX = 0.0f;
+		mouseDeltaY = 0.0f;
+	}
+	else {
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+	}
 }
 
 //callback for mouse scroll
@@ -1422,6 +1638,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
 	// F1 - Wireframe
 	// F2 - Culling
+	// P - Pause
+	// F3 - Physics counters
+	// F4 - Frame profiler
+	// F5 - Write the frame profiler history as Chrome trace
 	// Esc - Exit
 
 	if (action != GLFW_RELEASE) return;
@@ -1443,6 +1663,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	case GLFW_KEY_ESCAPE:
 		glfwSetWindowShouldClose(window, true);
 		break;
+	case GLFW_KEY_P:
+		if (gameState.getState() == PSTATE_PLAYING)
+			setGameState(window, PSTATE_PAUSED);
+		else if (gameState.getState() == PSTATE_PAUSED)
+			setGameState(window, PSTATE_PLAYING);
+		break;
 	case GLFW_KEY_F1:
 		_wireframe = !_wireframe;
 		glPolygonMode(GL_FRONT_AND_BACK, _wireframe ? GL_LINE : GL_FILL);
@@ -1452,6 +1678,24 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		if (_culling) glEnable(GL_CULL_FACE);
 		else glDisable(GL_CULL_FACE);
 		break;
+	case GLFW_KEY_F3:
+		// the counters are switched on the first time they are shown
+		showPhysicsStats = !showPhysicsStats;
+		if (showPhysicsStats) pWorld->setDiagnostics(pWorld->getDiagnostics() | PDIAG_COUNTERS);
+		break;
+	case GLFW_KEY_F4:
+		// profiling starts with the overlay and keeps running for the trace when it is hidden again
+		showProfiler = !showProfiler;
+		if (showProfiler) FrameProfiler::get().setEnabled(true);
+		break;
+	case GLFW_KEY_F5:
+		if (!FrameProfiler::get().isEnabled())
+			std::cout << "The frame profiler is off, F4 turns it on" << std::endl;
+		else if (FrameProfiler::get().exportChromeTrace(profilerTraceFile))
+			std::cout << "Frame trace written to " << profilerTraceFile << std::endl;
+		else
+			std::cout << "Could not write the frame trace to " << profilerTraceFile << std::endl;
+		break;
 
 	}
 }
@@ -12,11 +12,15 @@
 Material::Material(std::shared_ptr<Shader> shader, glm::vec3 materialCoefficients, float alpha)
 	: _shader(shader), _materialCoefficients(materialCoefficients), _alpha(alpha)
 {
+	_coefficientsLocation = _shader->getUni("materialCoefficients");
+	_alphaLocation = _shader->getUni("specularAlpha");
 }
 
 Material::Material(std::shared_ptr<Shader> shader)
 	: _shader(shader)
 {
+	_coefficientsLocation = _shader->getUni("materialCoefficients");
+	_alphaLocation = _shader->getUni("specularAlpha");
 }
 
 Material::~Material()
@@ -31,8 +35,8 @@ Shader* Material::getShader()
 void Material::setUniforms()
 {
 
-		_shader->setUniform("materialCoefficients", _materialCoefficients);
-		_shader->setUniform("specularAlpha", _alpha);
+		_shader->setUniform(_coefficientsLocation, _materialCoefficients);
+		_shader->setUniform(_alphaLocation, _alpha);
 
 }
 
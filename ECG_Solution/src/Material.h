@@ -32,6 +32,12 @@ protected:
 	 */
 	float _alpha;
 
+	/*!
+	 * Uniform locations, looked up once since a name string per draw would allocate
+	 */
+	GLint _coefficientsLocation;
+	GLint _alphaLocation;
+
 public:
 	/*!
 	 * Base material constructor
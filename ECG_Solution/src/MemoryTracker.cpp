@@ -0,0 +1,155 @@
+#include "MemoryTracker.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+
+static const char* SUBSYSTEM_NAMES[PMEM_SUBSYSTEM_COUNT] = { "meshes", "textures", "render_targets", "particles", "physics", "ui" };
+static const char* DOMAIN_NAMES[PMEM_DOMAIN_COUNT] = { "RAM", "VRAM" };
+
+static double toMegabytes(size_t bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+//raises the peak to the new live value, other threads may raise it at the same time
+static void raisePeak(std::atomic<size_t>& peak, size_t live)
+{
+	size_t current = peak.load(std::memory_order_relaxed);
+	while (live > current && !peak.compare_exchange_weak(current, live, std::memory_order_relaxed)) {
+	}
+}
+
+
+MemoryTracker::MemoryTracker()
+{
+}
+
+MemoryTracker& MemoryTracker::get()
+{
+	static MemoryTracker tracker;
+	return tracker;
+}
+
+void MemoryTracker::allocate(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes)
+{
+	Counter& counter = _counters[subsystem][domain];
+	size_t live = counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	raisePeak(counter.peak, live);
+	counter.allocations.fetch_add(1, std::memory_order_relaxed);
+
+	Counter& total = _totals[domain];
+	raisePeak(total.peak, total.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+	total.allocations.fetch_add(1, std::memory_order_relaxed);
+
+	size_t budget = counter.budget.load(std::memory_order_relaxed);
+	if (budget > 0 && live > budget && !counter.overBudget.exchange(true)) {
+		std::printf("Memory: %s uses %.1f MB of %s, over its budget of %.1f MB\n",
+			getName(subsystem), toMegabytes(live), getName(domain), toMegabytes(budget));
+	}
+}
+
+void MemoryTracker::release(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes)
+{
+	Counter& counter = _counters[subsystem][domain];
+	size_t live = counter.live.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+	_totals[domain].live.fetch_sub(bytes, std::memory_order_relaxed);
+
+	// warns again the next time it grows past the budget
+	if (live <= counter.budget.load(std::memory_order_relaxed))
+		counter.overBudget.store(false);
+}
+
+void MemoryTracker::setBudget(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes)
+{
+	_counters[subsystem][domain].budget.store(bytes);
+}
+
+bool MemoryTracker::isOverBudget(MemorySubsystem subsystem, MemoryDomain domain) const
+{
+	const Counter& counter = _counters[subsystem][domain];
+	size_t budget = counter.budget.load(std::memory_order_relaxed);
+	return budget > 0 && counter.live.load(std::memory_order_relaxed) > budget;
+}
+
+MemoryCounters MemoryTracker::getCounters(MemorySubsystem subsystem, MemoryDomain domain) const
+{
+	const Counter& counter = _counters[subsystem][domain];
+	MemoryCounters counters;
+	counters.live = counter.live.load(std::memory_order_relaxed);
+	counters.peak = counter.peak.load(std::memory_order_relaxed);
+	counters.budget = counter.budget.load(std::memory_order_relaxed);
+	counters.allocations = counter.allocations.load(std::memory_order_relaxed);
+	return counters;
+}
+
+MemoryCounters MemoryTracker::getTotal(MemoryDomain domain) const
+{
+	const Counter& total = _totals[domain];
+	MemoryCounters counters;
+	counters.live = total.live.load(std::memory_order_relaxed);
+	counters.peak = total.peak.load(std::memory_order_relaxed);
+	counters.allocations = total.allocations.load(std::memory_order_relaxed);
+	return counters;
+}
+
+void MemoryTracker::printReport(std::ostream& stream) const
+{
+	char line[160];
+	stream << "Memory in MB          RAM live   RAM peak  RAM budget  VRAM live  VRAM peak  VRAM budget" << std::endl;
+	for (int s = 0; s < PMEM_SUBSYSTEM_COUNT; s++) {
+		MemoryCounters ram = getCounters(MemorySubsystem(s), PMEM_RAM);
+		MemoryCounters vram = getCounters(MemorySubsystem(s), PMEM_VRAM);
+		std::snprintf(line, sizeof(line), "%-18s %11.2f %10.2f %11.1f %10.2f %10.2f %12.1f%s",
+			getName(MemorySubsystem(s)), toMegabytes(ram.live), toMegabytes(ram.peak), toMegabytes(ram.budget),
+			toMegabytes(vram.live), toMegabytes(vram.peak), toMegabytes(vram.budget),
+			isOverBudget(MemorySubsystem(s), PMEM_RAM) || isOverBudget(MemorySubsystem(s), PMEM_VRAM) ? "  over budget" : "");
+		stream << line << std::endl;
+	}
+
+	MemoryCounters ram = getTotal(PMEM_RAM);
+	MemoryCounters vram = getTotal(PMEM_VRAM);
+	std::snprintf(line, sizeof(line), "%-18s %11.2f %10.2f %11s %10.2f %10.2f", "total",
+		toMegabytes(ram.live), toMegabytes(ram.peak), "", toMegabytes(vram.live), toMegabytes(vram.peak));
+	stream << line << std::endl;
+}
+
+const char* MemoryTracker::getName(MemorySubsystem subsystem)
+{
+	return subsystem >= 0 && subsystem < PMEM_SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[subsystem] : "unknown";
+}
+
+const char* MemoryTracker::getName(MemoryDomain domain)
+{
+	return domain >= 0 && domain < PMEM_DOMAIN_COUNT ? DOMAIN_NAMES[domain] : "unknown";
+}
+
+
+void parseMemoryBudgets(const std::string& budgets, MemoryDomain domain)
+{
+	std::stringstream stream(budgets);
+	std::string entry;
+	while (std::getline(stream, entry, ',')) {
+		if (entry.find_first_not_of(" \t") == std::string::npos)
+			continue;
+		size_t colon = entry.find(':');
+		if (colon == std::string::npos) {
+			std::cout << "Memory budget '" << entry << "' is not name:MB" << std::endl;
+			continue;
+		}
+		std::string name = entry.substr(0, colon);
+		name.erase(0, name.find_first_not_of(" \t"));
+		name.erase(name.find_last_not_of(" \t") + 1);
+		double megabytes = std::atof(entry.c_str() + colon + 1);
+
+		int subsystem = 0;
+		while (subsystem < PMEM_SUBSYSTEM_COUNT && name != SUBSYSTEM_NAMES[subsystem])
+			subsystem++;
+		if (subsystem == PMEM_SUBSYSTEM_COUNT) {
+			std::cout << "Memory budget for unknown subsystem '" << name << "'" << std::endl;
+			continue;
+		}
+		MemoryTracker::get().setBudget(MemorySubsystem(subsystem), domain, size_t(megabytes > 0.0 ? megabytes * 1024.0 * 1024.0 : 0.0));
+	}
+}
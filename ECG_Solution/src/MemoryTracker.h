@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+//who an allocation belongs to
+enum MemorySubsystem {
+
+	PMEM_MESHES,
+	PMEM_TEXTURES,
+	//framebuffer attachments of the post processing
+	PMEM_RENDER_TARGETS,
+	PMEM_PARTICLES,
+	PMEM_PHYSICS,
+	PMEM_UI,
+	PMEM_SUBSYSTEM_COUNT
+};
+
+enum MemoryDomain {
+
+	PMEM_RAM,
+	PMEM_VRAM,
+	PMEM_DOMAIN_COUNT
+};
+
+struct MemoryCounters {
+
+	size_t live = 0;
+	size_t peak = 0;
+	//0 = no budget
+	size_t budget = 0;
+	unsigned int allocations = 0;
+};
+
+/*
+Live and peak bytes of every subsystem, in RAM and in VRAM.
+Tracked allocators and the GPU wrappers report to it, from any thread. A budget prints
+a warning whenever a subsystem grows past it, once until it dropped below again.
+*/
+class MemoryTracker
+{
+private:
+	struct Counter {
+
+		std::atomic<size_t> live;
+		std::atomic<size_t> peak;
+		std::atomic<size_t> budget;
+		std::atomic<unsigned int> allocations;
+		std::atomic<bool> overBudget;
+
+		Counter() : live(0), peak(0), budget(0), allocations(0), overBudget(false) {}
+	};
+
+	Counter _counters[PMEM_SUBSYSTEM_COUNT][PMEM_DOMAIN_COUNT];
+	//the peak of the sum is not the sum of the peaks
+	Counter _totals[PMEM_DOMAIN_COUNT];
+
+	MemoryTracker();
+
+public:
+	static MemoryTracker& get();
+
+	void allocate(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes);
+	void release(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes);
+
+	void setBudget(MemorySubsystem subsystem, MemoryDomain domain, size_t bytes);
+	bool isOverBudget(MemorySubsystem subsystem, MemoryDomain domain) const;
+
+	MemoryCounters getCounters(MemorySubsystem subsystem, MemoryDomain domain) const;
+	MemoryCounters getTotal(MemoryDomain domain) const;
+
+	//live, peak and budget of every subsystem as a table in MB
+	void printReport(std::ostream& stream) const;
+
+	static const char* getName(MemorySubsystem subsystem);
+	static const char* getName(MemoryDomain domain);
+};
+
+//budgets in MB per subsystem, like "textures:128, meshes:64", unknown names are reported and skipped
+void parseMemoryBudgets(const std::string& budgets, MemoryDomain domain);
+
+
+//counts the RAM of a container for a subsystem, the memory itself comes from the general heap
+template <typename T, MemorySubsystem S>
+class TrackedAllocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef TrackedAllocator<U, S> other;
+	};
+
+	TrackedAllocator() {}
+
+	template <typename U>
+	TrackedAllocator(const TrackedAllocator<U, S>&) {}
+
+	T* allocate(size_t count)
+	{
+		T* memory = static_cast<T*>(::operator new(count * sizeof(T)));
+		MemoryTracker::get().allocate(S, PMEM_RAM, count * sizeof(T));
+		return memory;
+	}
+
+	void deallocate(T* memory, size_t count)
+	{
+		MemoryTracker::get().release(S, PMEM_RAM, count * sizeof(T));
+		::operator delete(memory);
+	}
+
+	template <typename U>
+	bool operator==(const TrackedAllocator<U, S>&) const
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const TrackedAllocator<U, S>&) const
+	{
+		return false;
+	}
+};
+
+template <typename T, MemorySubsystem S>
+using TrackedVector = std::vector<T, TrackedAllocator<T, S>>;
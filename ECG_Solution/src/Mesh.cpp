@@ -1,34 +1,22 @@
 #include "Mesh.h"
+#include "GpuMemory.h"
 
 Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<ModelTexture> textures) 
 {
-	this->vertices = vertices;
-	this->indices = indices;
+	this->vertices.assign(vertices.begin(), vertices.end());
+	this->indices.assign(indices.begin(), indices.end());
+	indexCount = static_cast<unsigned int>(indices.size());
 	this->textures = textures;
 
-	setupMesh();
-}
-
-Mesh::~Mesh()
-{
-
-}
- 
-void Mesh::Draw(Shader& shader)
-{
-	// bind appropriate textures
 	unsigned int diffuseNr = 1;
 	unsigned int specularNr = 1;
 	unsigned int normalNr = 1;
 	unsigned int heightNr = 1;
 
-	for (unsigned int i = 0; i < textures.size(); i++) 
+	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		//activate texture 
-		glActiveTexture(GL_TEXTURE0 + i);
-
 		string number;
-		string name = textures[i].type;
+		const string& name = textures[i].type;
 		if (name == "texture_diffuse")
 		{
 			number = std::to_string(diffuseNr++);
@@ -45,22 +33,63 @@ void Mesh::Draw(Shader& shader)
 		{
 			number = std::to_string(heightNr++);
 		}
+		samplerNames.push_back(name + number);
+	}
+
+	setupMesh();
+}
+
+Mesh::~Mesh()
+{
+
+}
+ 
+void Mesh::Draw(Shader& shader)
+{
+	// bind appropriate textures
+	if (samplerShader != &shader)
+	{
+		samplerShader = &shader;
+		samplerLocations.resize(samplerNames.size());
+		for (unsigned int i = 0; i < samplerNames.size(); i++)
+			samplerLocations[i] = shader.getUni(samplerNames[i]);
+	}
+
+	for (unsigned int i = 0; i < textures.size(); i++) 
+	{
+		//activate texture 
+		glActiveTexture(GL_TEXTURE0 + i);
 
 		//set sampler to texture unit
-		glUniform1i(shader.getUni((name+number).c_str()), i);
+		glUniform1i(samplerLocations[i], i);
 		//glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
 		//bind texture
 		glBindTexture(GL_TEXTURE_2D, textures[i].id);
 	}  
 	// draw mesh
 	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
 	glBindVertexArray(0);
 
 	// always good practice to set everything back to defaults once configured.
 	glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::releaseCpuData()
+{
+	// swapping with an empty vector gives the memory back, clear would keep it
+	TrackedVector<Vertex, PMEM_MESHES>().swap(vertices);
+	TrackedVector<unsigned int, PMEM_MESHES>().swap(indices);
+}
+
+void Mesh::release()
+{
+	gpuDeleteBuffers(1, &VBO);
+	gpuDeleteBuffers(1, &EBO);
+	glDeleteVertexArrays(1, &VAO);
+	VBO = EBO = VAO = 0;
+}
+
 void Mesh::setupMesh() 
 {
 	//create & bind buffers/arrays
@@ -72,12 +101,12 @@ void Mesh::setupMesh()
 	//VERTEX BUFFER OBJECT
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ARRAY_BUFFER, VBO, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
 	//ELEMENT BUFFER OBJECT
 	glGenBuffers(1, &EBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	gpuBufferData(PMEM_MESHES, GL_ELEMENT_ARRAY_BUFFER, EBO, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
 
 	//vertex attributes and pointes
@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Shader.h"
+#include "MemoryTracker.h"
 
 #include <string>
 #include <vector>
@@ -37,9 +38,9 @@ struct ModelTexture {
 class Mesh {
 
 public:
-    // mesh Data
-    vector<Vertex>       vertices;
-    vector<unsigned int> indices;
+    // mesh Data, the CPU copy is only needed until the colliders are cooked
+    TrackedVector<Vertex, PMEM_MESHES>       vertices;
+    TrackedVector<unsigned int, PMEM_MESHES> indices;
     vector<ModelTexture>      textures;
     unsigned int VAO;
 
@@ -51,8 +52,21 @@ public:
     // used to render the mesh
     void Draw(Shader &shader);
 
+    // frees the CPU copy of vertices and indices, the GPU buffers stay
+    void releaseCpuData();
+
+    // deletes the GPU buffers, meshes are copied around so the destructor can not do it
+    void release();
+
 private:
     unsigned int VBO, EBO;
+    unsigned int indexCount;
+
+    // sampler uniform of every texture, e.g. texture_diffuse1, named once instead of every draw
+    vector<string> samplerNames;
+    // locations of the sampler names in the shader that drew the mesh last
+    Shader* samplerShader = nullptr;
+    vector<GLint> samplerLocations;
 
     // initializes all the buffer objects/arrays
     void setupMesh();
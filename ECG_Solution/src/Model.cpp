@@ -1,13 +1,16 @@
 #pragma once
 
 #include "Model.h"
+#include "FrameProfiler.h"
+#include "TransformSystem.h"
+#include "GpuMemory.h"
 #define STB_IMAGE_IMPLEMENTATION    
 #include "stb/stb_image.h"
 
 
 
 Model::Model(string const& path, glm::mat4 modelMatrix,Shader& shader ,bool gamma) : 
-    gammaCorrection(gamma), _modelMatrix(modelMatrix), _shader(&shader)
+    _shader(&shader), gammaCorrection(gamma), _modelMatrix(modelMatrix), _normalMatrix(computeNormalMatrix(modelMatrix))
 {
     
     loadModel(path);
@@ -15,18 +18,29 @@ Model::Model(string const& path, glm::mat4 modelMatrix,Shader& shader ,bool gamm
 
 Model::~Model()
 {
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].release();
+    for (unsigned int i = 0; i < textures_loaded.size(); i++)
+        gpuDeleteTextures(1, &textures_loaded[i].id);
+}
 
+void Model::releaseCpuData()
+{
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].releaseCpuData();
 }
 
 void Model::setModel(glm::mat4 model) {
 
     _modelMatrix = model;
+    _normalMatrix = computeNormalMatrix(model);
 
 }
 
 void Model::resetModelMatrix()
 {
     _modelMatrix = glm::mat4(1);
+    _normalMatrix = glm::mat3(1);
 }
 
 glm::mat4 Model::getModel() {
@@ -34,12 +48,26 @@ glm::mat4 Model::getModel() {
     return _modelMatrix;
 }
 
+const glm::mat3& Model::getNormalMatrix() {
+
+    return _normalMatrix;
+}
+
 void Model::Draw(glm::mat4 model)
     {
+    PROFILE_SCOPE("model draw");
     _shader->setUniform("modelMatrix", model);
         for (unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(*_shader);
     }
+void Model::Draw(const glm::mat4& model, const glm::mat3& normalMatrix)
+{
+    PROFILE_SCOPE("model draw");
+    _shader->setUniform("modelMatrix", model);
+    _shader->setUniform("normalMatrix", normalMatrix);
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].Draw(*_shader);
+}
 void Model::Draw(Shader& shader)
 {
    
@@ -53,7 +81,7 @@ void Model::Draw(float time, glm::mat4 model)
     _shader->setUniform("metallic", 0.1f);
     _shader->setUniform("roughness", 0.1f);
     _shader->setUniform("ao", 0.5f);
-    _shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
+    _shader->setUniform("normalMatrix", computeNormalMatrix(model));
     for (unsigned int i = 0; i < meshes.size(); i++)
         meshes[i].Draw(*_shader);
 }
@@ -238,6 +266,7 @@ unsigned int TextureFromFile(const char* path, const string& directory, bool gam
         glBindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        gpuTrackTexture(PMEM_TEXTURES, textureID);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -37,10 +37,16 @@ public:
     // constructor, expects a filepath to a 3D model.
     Model(string const& path, glm::mat4 modelMatrix,  Shader& shader, bool gamma = false);
 
+    // deletes the GPU buffers of the meshes and the textures the model loaded
     ~Model();
 
+    // frees the CPU copy of the meshes, call it once the colliders were cooked from them
+    void releaseCpuData();
+
     // draws the model, and thus all its meshes
     void Draw(glm::mat4 model);
+    // the normal matrix of the transform component, nothing is inverted per draw
+    void Draw(const glm::mat4& model, const glm::mat3& normalMatrix);
     void Draw(Shader& shader);
     void Model::Draw(float time, glm::mat4 model);
     void setModel(glm::mat4 model);
@@ -50,9 +56,13 @@ public:
 
     glm::mat4 getModel();
 
+    // kept up to date by setModel and resetModelMatrix
+    const glm::mat3& getNormalMatrix();
+
 private:
 
     glm::mat4 _modelMatrix;
+    glm::mat3 _normalMatrix;
 
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const& path);
@@ -0,0 +1,371 @@
+#include "ParticleEmitter.h"
+#include <algorithm>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/constants.hpp>
+
+
+//red, green and alpha fade by this many steps of their byte per second of age, blue stays
+static const float COLOR_FADE_PER_SECOND = 60.0f;
+
+//a color byte after fade steps, it never wraps around below zero
+static unsigned char fadeChannel(unsigned char channel, float fade)
+{
+	return fade < channel ? static_cast<unsigned char>(channel - fade) : 0;
+}
+
+
+ParticleEmitter::ParticleEmitter(const EmitterSettings& settings)
+	: ParticleEmitter(settings, std::random_device()()) {
+}
+
+ParticleEmitter::ParticleEmitter(const EmitterSettings& settings, unsigned int seed)
+	: _settings(settings), _offsetFactor(settings.offsetFactor), _size(settings.size), _amount(settings.amount), _position(settings.position),
+	_rng(seed) {
+
+	_particles.resize(_amount);
+	_instances.resize(_amount);
+	if (hasRotationFrame()) {
+		_rotationFrames.resize(_amount * 2);
+	}
+
+	// every particle starts out dead, the lowest index is handed out first
+	_alive.reserve(_amount * 2);
+	_dead.reserve(_amount);
+	_drawOrder.reserve(_amount);
+	for (unsigned int i = _amount; i > 0; i--) {
+		_dead.push_back(i - 1);
+	}
+}
+
+
+void ParticleEmitter::Simulate(float deltaTime, unsigned int newParticles, glm::vec3 cameraPosition,
+	glm::vec3 objectPosition)
+{
+	_stats.spawned = 0;
+	_stats.died = 0;
+	_lastObjectPosition = objectPosition;
+	_lastCameraPosition = cameraPosition;
+
+	if (!_visible) {
+		catchUp();
+	}
+
+	// the spawn rate is per update, remember how long an update usually is for prewarming
+	_averageDeltaTime += (deltaTime - _averageDeltaTime) * 0.1f;
+
+	Spawn(newParticles, objectPosition);
+	Integrate(deltaTime, cameraPosition);
+	Sort();
+	Pack(cameraPosition);
+}
+
+
+void ParticleEmitter::Spawn(unsigned int newParticles, glm::vec3 objectPosition)
+{
+	for (unsigned int i = 0; i < newParticles; ++i)
+	{
+		int unusedParticle = allocateParticle();
+		if (unusedParticle < 0)
+			break;
+		respawnParticle(_particles[unusedParticle], objectPosition);
+		_stats.spawned++;
+	}
+}
+
+
+void ParticleEmitter::Integrate(float deltaTime, glm::vec3 cameraPosition)
+{
+	// only the live particles are visited, dead ones are compacted out in place so the spawn order is kept
+	size_t aliveCount = 0;
+	for (size_t i = _aliveBegin; i < _alive.size(); ++i)
+	{
+		unsigned int index = _alive[i];
+		Particle& temp = _particles[index];
+
+		advanceParticle(temp, deltaTime);
+
+		if (temp._life > 0.0f)
+		{
+			temp.camDistance = glm::length2(temp._position - cameraPosition);
+
+			_alive[aliveCount++] = index;
+		}
+		else {
+
+			temp.camDistance = -1;
+			_dead.push_back(index);
+			_stats.died++;
+		}
+	}
+	_alive.resize(aliveCount);
+	_aliveBegin = 0;
+
+	_stats.alive = static_cast<unsigned int>(aliveCount);
+	_stats.capacity = _amount;
+}
+
+
+void ParticleEmitter::advanceParticle(Particle& particle, float deltaTime)
+{
+	particle._life -= deltaTime;
+	if (particle._life <= 0.0f)
+		return;
+
+	particle._position += particle._velocity * deltaTime;
+	particle._rotation += particle._angularVelocity * deltaTime;
+}
+
+
+void ParticleEmitter::Sort()
+{
+	// back to front, additive blending does not care about the order
+	_drawOrder.assign(_alive.begin(), _alive.end());
+	if (_settings.blendMode != PBLEND_ALPHA)
+		return;
+
+	const TrackedVector<Particle, PMEM_PARTICLES>& particles = _particles;
+	std::sort(_drawOrder.begin(), _drawOrder.end(), [&particles](unsigned int a, unsigned int b) {
+		return particles[a] < particles[b];
+	});
+}
+
+
+void ParticleEmitter::Pack(glm::vec3 origin)
+{
+	_pCount = 0;
+	_packOrigin = origin;
+
+	bool rotationFrame = hasRotationFrame();
+	float rotationScale = 65535.0f / glm::two_pi<float>();
+	float frameScale = _settings.flipbookFrames / _settings.life;
+
+	for (size_t i = 0; i < _drawOrder.size(); ++i)
+	{
+		Particle& temp = _particles[_drawOrder[i]];
+		PackedParticle& packed = _instances[_pCount];
+
+		// Fill the GPU buffer
+		glm::vec3 relative = temp._position - _packOrigin;
+		packed.position[0] = glm::packHalf1x16(relative.x);
+		packed.position[1] = glm::packHalf1x16(relative.y);
+		packed.position[2] = glm::packHalf1x16(relative.z);
+		packed.size = glm::packHalf1x16(temp._size);
+
+		// the fade follows the age, so it is the same for any step size and after a catch up
+		float fade = (_settings.life - temp._life) * COLOR_FADE_PER_SECOND;
+		packed.color[0] = fadeChannel(temp.r, fade);
+		packed.color[1] = fadeChannel(temp.g, fade);
+		packed.color[2] = temp.b;
+		packed.color[3] = fadeChannel(temp.a, fade);
+
+		if (rotationFrame) {
+			float angle = glm::mod(temp._rotation, glm::two_pi<float>());
+			unsigned int frame = static_cast<unsigned int>((_settings.life - temp._life) * frameScale);
+			_rotationFrames[2 * _pCount + 0] = static_cast<uint16_t>(angle * rotationScale);
+			_rotationFrames[2 * _pCount + 1] = static_cast<uint16_t>(std::min(frame, _settings.flipbookFrames - 1));
+		}
+
+		_pCount++;
+	}
+}
+
+
+void ParticleEmitter::catchUp()
+{
+	_visible = true;
+	float hiddenTime = _hiddenTime;
+	_hiddenTime = 0.0f;
+
+	if (hiddenTime <= 0.0f)
+		return;
+
+	// particles fly in a straight line and their color follows from their age, so a single step brings everything alive to where it would be now,
+	// the ones that would have been spawned in the meantime are spawned now and aged by the time since their birth
+	if (hiddenTime < _settings.life) {
+		Integrate(hiddenTime, _lastCameraPosition);
+
+		unsigned int missed = static_cast<unsigned int>(_settings.spawnCount * hiddenTime / _averageDeltaTime + 0.5f);
+		std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+		for (unsigned int i = 0; i < missed; ++i) {
+			int unusedParticle = allocateParticle();
+			if (unusedParticle < 0)
+				break;
+			Particle& particle = _particles[unusedParticle];
+			respawnParticle(particle, _lastObjectPosition);
+
+			// one random age per slice of the hidden time, oldest first like the alive list expects
+			float age = hiddenTime * (missed - 1 - i + jitter(_rng)) / missed;
+			advanceParticle(particle, age);
+			_stats.spawned++;
+		}
+		return;
+	}
+
+	// everything that was alive has died in the meantime, rebuild a steady state emitter
+	for (size_t i = _aliveBegin; i < _alive.size(); ++i) {
+		_particles[_alive[i]]._life = 0.0f;
+		_dead.push_back(_alive[i]);
+	}
+	_alive.clear();
+	_aliveBegin = 0;
+
+	const float prewarmStep = std::max(_averageDeltaTime, 1.0f / 30.0f);
+	unsigned int spawnPerStep = static_cast<unsigned int>(_settings.spawnCount * prewarmStep / _averageDeltaTime + 0.5f);
+	for (float time = 0.0f; time < _settings.life; time += prewarmStep) {
+		Spawn(spawnPerStep, _lastObjectPosition);
+		Integrate(prewarmStep, _lastCameraPosition);
+	}
+}
+
+
+int ParticleEmitter::allocateParticle()
+{
+	if (!_dead.empty()) {
+		unsigned int index = _dead.back();
+		_dead.pop_back();
+		_alive.push_back(index);
+		return index;
+	}
+
+	switch (_settings.overflowPolicy) {
+	case POVERFLOW_STEAL_OLDEST: {
+		if (_aliveBegin >= _alive.size())
+			break;
+		// the front of the alive list is the oldest particle, it is moved to the back as the newest one
+		unsigned int index = _alive[_aliveBegin++];
+		_alive.push_back(index);
+		_stats.stolen++;
+		return index;
+	}
+	case POVERFLOW_GROW: {
+		unsigned int index = _amount++;
+		_particles.push_back(Particle());
+		_instances.resize(_amount);
+		if (hasRotationFrame()) {
+			_rotationFrames.resize(_amount * 2);
+		}
+		_alive.push_back(index);
+		_stats.grown++;
+		return index;
+	}
+	case POVERFLOW_DROP:
+	default:
+		break;
+	}
+
+	_stats.dropped++;
+	return -1;
+}
+
+void ParticleEmitter::respawnParticle(Particle& particle, glm::vec3 objectPosition)
+{
+
+	std::uniform_real_distribution<float> distMinus(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> distSize(0.0f, _size);
+
+	glm::vec3 offset = glm::vec3(
+		distMinus(_rng),
+		distMinus(_rng),
+		distMinus(_rng)
+	);
+
+	particle._position = objectPosition + _position + offset * _offsetFactor;
+
+	glm::vec3 mainDirection = _settings.direction;
+	glm::vec3 randomDirection = glm::vec3(
+		distMinus(_rng) / 2.0f,
+		distMinus(_rng) / 2.0f,
+		distMinus(_rng) / 2.0f
+	);
+
+	float spread = _settings.spread;
+
+	particle._life = _settings.life;
+	particle._velocity = mainDirection + randomDirection * spread;
+	particle._size = distSize(_rng);
+
+	particle.r = _settings.r;
+	particle.g = _settings.g;
+	particle.b = _settings.b;
+	particle.a = _settings.a;
+
+	if (_settings.rotationSpeed != 0.0f) {
+		particle._rotation = (distMinus(_rng) + 1.0f) * glm::pi<float>();
+		particle._angularVelocity = distMinus(_rng) * _settings.rotationSpeed;
+	}
+
+}
+
+const EmitterSettings& ParticleEmitter::getSettings()
+{
+	return _settings;
+}
+
+void ParticleEmitter::setPosition(glm::vec3 position)
+{
+	_position = position;
+	_settings.position = position;
+}
+
+glm::vec3 ParticleEmitter::getPosition()
+{
+	return _position;
+}
+
+unsigned int ParticleEmitter::getParticleCount()
+{
+	return _pCount;
+}
+
+unsigned int ParticleEmitter::getCapacity()
+{
+	return _amount;
+}
+
+const PackedParticle* ParticleEmitter::getInstanceData()
+{
+	return _instances.data();
+}
+
+bool ParticleEmitter::hasRotationFrame()
+{
+	return _settings.rotationSpeed != 0.0f || _settings.flipbookFrames > 0;
+}
+
+const uint16_t* ParticleEmitter::getRotationFrameData()
+{
+	return _rotationFrames.data();
+}
+
+glm::vec3 ParticleEmitter::getPackOrigin()
+{
+	return _packOrigin;
+}
+
+const ParticleStats& ParticleEmitter::getStats()
+{
+	return _stats;
+}
+
+void ParticleEmitter::getBounds(glm::vec3& boxMin, glm::vec3& boxMax)
+{
+	// spawn offset plus the furthest a particle can travel during its life
+	float maxSpeed = glm::length(_settings.direction) + _settings.spread * 0.5f * 1.7320508f;
+	glm::vec3 extent = glm::vec3(_offsetFactor + maxSpeed * _settings.life + _size);
+	glm::vec3 center = _lastObjectPosition + _position;
+
+	boxMin = center - extent;
+	boxMax = center + extent;
+}
+
+void ParticleEmitter::Hide(float deltaTime)
+{
+	_visible = false;
+	_hiddenTime += deltaTime;
+	_pCount = 0;
+}
+
+bool ParticleEmitter::isVisible()
+{
+	return _visible;
+}
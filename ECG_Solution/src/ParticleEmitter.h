@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "MemoryTracker.h"
+
+
+
+struct Particle {
+
+	glm::vec3 _position;
+	glm::vec3 _velocity;
+	glm::vec4 _color;
+	float _life;
+	float _size;
+	float camDistance;
+	float _rotation;
+	float _angularVelocity;
+	//the color it was spawned with
+	unsigned char r, g, b, a;
+
+	Particle() : _position(0.0f), _velocity(0.0f), _color(1.0f), _life(0.0f), _rotation(0.0f), _angularVelocity(0.0f) {}
+
+	bool operator<(const Particle& that) const {
+		return this->camDistance > that.camDistance;
+	}
+};
+
+//instance layout that is uploaded to the GPU, 12 bytes per particle instead of 20
+//the position is stored relative to the camera so half floats keep enough precision close to the viewer
+struct PackedParticle {
+
+	uint16_t position[3];	// half floats
+	uint16_t size;			// half float
+	uint8_t color[4];		// rgba8
+};
+
+//how the particles of an emitter are blended into the scene
+enum ParticleBlendMode {
+
+	PBLEND_ALPHA,
+	PBLEND_ADDITIVE,
+	PBLEND_COUNT
+};
+
+//what happens when an emitter wants to spawn but every particle of its pool is alive
+enum ParticleOverflowPolicy {
+
+	POVERFLOW_DROP,
+	POVERFLOW_STEAL_OLDEST,
+	POVERFLOW_GROW
+};
+
+//counters of the last Simulate, the overflow counters are accumulated over the whole lifetime
+struct ParticleStats {
+
+	unsigned int alive = 0;
+	unsigned int capacity = 0;
+	unsigned int spawned = 0;
+	unsigned int died = 0;
+	unsigned int dropped = 0;
+	unsigned int stolen = 0;
+	unsigned int grown = 0;
+
+	void add(const ParticleStats& other) {
+		alive += other.alive;
+		capacity += other.capacity;
+		spawned += other.spawned;
+		died += other.died;
+		dropped += other.dropped;
+		stolen += other.stolen;
+		grown += other.grown;
+	}
+};
+
+//parameters of a single emitter
+struct EmitterSettings {
+
+	glm::vec3 position = glm::vec3(0.0f);
+	float offsetFactor = 1.0f;
+	float size = 0.15f;
+	unsigned int amount = 100;
+
+	//particles spawned per update
+	unsigned int spawnCount = 3;
+	float life = 2.0f;
+	float spread = 1.5f;
+	glm::vec3 direction = glm::vec3(0.0f, 1.0f, 0.0f);
+	unsigned char r = 255, g = 215, b = 0, a = 127;
+
+	//optional per particle rotation (max radians per second) and flipbook frame, adds 4 bytes per instance
+	float rotationSpeed = 0.0f;
+	unsigned int flipbookFrames = 0;
+
+	ParticleBlendMode blendMode = PBLEND_ALPHA;
+	ParticleOverflowPolicy overflowPolicy = POVERFLOW_STEAL_OLDEST;
+};
+
+/*
+The simulation of a single emitter without any GL or window dependency.
+Simulate runs the four phases Spawn, Integrate, Sort and Pack in that order,
+they are public so the benchmark can time them one by one.
+*/
+class ParticleEmitter
+{
+
+private:
+	TrackedVector<Particle, PMEM_PARTICLES> _particles;
+	EmitterSettings _settings;
+	ParticleStats _stats;
+	float _offsetFactor;
+	float _size;
+	unsigned int _amount;
+	int _pCount = 0;
+	glm::vec3 _position;
+
+	//indices into _particles: the live ones in spawn order starting at _aliveBegin, the free ones as a stack
+	TrackedVector<unsigned int, PMEM_PARTICLES> _alive;
+	size_t _aliveBegin = 0;
+	TrackedVector<unsigned int, PMEM_PARTICLES> _dead;
+	TrackedVector<unsigned int, PMEM_PARTICLES> _drawOrder;
+
+	//visibility, hidden emitters are not simulated and catch up once they are seen again
+	bool _visible = true;
+	float _hiddenTime = 0.0f;
+	float _averageDeltaTime = 1.0f / 60.0f;
+	glm::vec3 _lastObjectPosition = glm::vec3(0.0f);
+	glm::vec3 _lastCameraPosition = glm::vec3(0.0f);
+
+	//every emitter owns its generator so emitters can be updated on different threads
+	std::mt19937 _rng;
+
+	//packed instances of the last Pack, the rotation/frame stream is only filled if the emitter uses it
+	TrackedVector<PackedParticle, PMEM_PARTICLES> _instances;
+	TrackedVector<uint16_t, PMEM_PARTICLES> _rotationFrames;
+	glm::vec3 _packOrigin = glm::vec3(0.0f);
+
+	//returns the index of the particle to respawn or -1 if the overflow policy drops it
+	int allocateParticle();
+	void respawnParticle(Particle& particle, glm::vec3 objectPosition);
+	//moves a particle along, it is dead once its life is used up, the color fades with its age in Pack
+	void advanceParticle(Particle& particle, float deltaTime);
+
+	//brings a hidden emitter up to date, either by moving the live particles forward or by prewarming from scratch
+	void catchUp();
+
+public:
+	ParticleEmitter(const EmitterSettings& settings);
+	ParticleEmitter(const EmitterSettings& settings, unsigned int seed);
+
+	//spawns, integrates, sorts and packs relative to the camera
+	void Simulate(float deltaTime, unsigned int newParticles, glm::vec3 cameraPosition, glm::vec3 objectPosition = glm::vec3(0.f));
+
+	//the single phases of Simulate
+	void Spawn(unsigned int newParticles, glm::vec3 objectPosition);
+	void Integrate(float deltaTime, glm::vec3 cameraPosition);
+	//back to front order of the live particles, only alpha blended emitters are sorted
+	void Sort();
+	//fills the instance buffers in draw order, positions are relative to origin
+	void Pack(glm::vec3 origin);
+
+	const EmitterSettings& getSettings();
+	void setPosition(glm::vec3 position);
+	glm::vec3 getPosition();
+
+	//packed instance data of the last Pack
+	unsigned int getParticleCount();
+	unsigned int getCapacity();
+	const PackedParticle* getInstanceData();
+
+	//two 16 bit values per particle: rotation (0..65535 = 0..2pi) and flipbook frame
+	bool hasRotationFrame();
+	const uint16_t* getRotationFrameData();
+
+	//camera position the instance positions are relative to
+	glm::vec3 getPackOrigin();
+
+	const ParticleStats& getStats();
+
+	//world space box that contains every particle the emitter can produce
+	void getBounds(glm::vec3& boxMin, glm::vec3& boxMax);
+
+	//marks the emitter as hidden for this frame, the time is accumulated and replayed when it gets visible again
+	void Hide(float deltaTime);
+	bool isVisible();
+};
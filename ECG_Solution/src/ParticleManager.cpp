@@ -0,0 +1,251 @@
+#include "ParticleManager.h"
+#include "FrameProfiler.h"
+#include "GpuMemory.h"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+
+static const GLfloat billboard_vertex_data[12] = {
+	-0.5f, -0.5f, 0.0f,
+	0.5f, -0.5f, 0.0f,
+	-0.5f, 0.5f, 0.0f,
+	0.5f, 0.5f, 0.0f
+};
+
+
+ParticleManager::ParticleManager(std::shared_ptr<Shader>& shader, Camera& cam, ThreadPool& pool)
+	: _shader(shader), _camera(&cam), _pool(&pool)
+{
+}
+
+ParticleManager::~ParticleManager()
+{
+	if (_vao != 0) {
+		gpuDeleteBuffers(1, &_particles_rotation_buffer);
+		gpuDeleteBuffers(1, &_particles_instance_buffer);
+		gpuDeleteBuffers(1, &_billboard_vertex_buffer);
+		glDeleteVertexArrays(1, &_vao);
+	}
+}
+
+ParticleEmitter* ParticleManager::addEmitter(const EmitterSettings& settings)
+{
+	_emitters.push_back(std::unique_ptr<ParticleEmitter>(new ParticleEmitter(settings)));
+	return _emitters.back().get();
+}
+
+void ParticleManager::init()
+{
+	_viewProjectionLocation = _shader->getUni("viewProjectionMatrix");
+
+	glGenVertexArrays(1, &_vao);
+	glBindVertexArray(_vao);
+
+	// 1st attribute buffer : vertices, always reuse the same 4 vertices
+	glGenBuffers(1, &_billboard_vertex_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, _billboard_vertex_buffer);
+	gpuBufferData(PMEM_PARTICLES, GL_ARRAY_BUFFER, _billboard_vertex_buffer, sizeof(billboard_vertex_data), billboard_vertex_data, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+	glVertexAttribDivisor(0, 0);
+
+	// 2nd and 3rd attribute : packed instances, camera relative half float position + size and rgba8 color, one per quad
+	glGenBuffers(1, &_particles_instance_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, _particles_instance_buffer);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedParticle), (void*)offsetof(PackedParticle, position));
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedParticle), (void*)offsetof(PackedParticle, color));
+	glVertexAttribDivisor(2, 1);
+
+	// 4th attribute : rotation and flipbook frame, only enabled for draws that need it
+	glGenBuffers(1, &_particles_rotation_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, _particles_rotation_buffer);
+	glVertexAttribIPointer(3, 2, GL_UNSIGNED_SHORT, 0, (void*)0);
+	glVertexAttribDivisor(3, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleManager::resizeBuffers(unsigned int capacity)
+{
+	_capacity = capacity;
+	_instanceData.resize(_capacity);
+	_rotationFrameData.resize(_capacity * 2);
+}
+
+void ParticleManager::setOcclusionTest(std::function<bool(glm::vec3, glm::vec3)> occlusionTest)
+{
+	_occlusionTest = occlusionTest;
+}
+
+bool ParticleManager::isEmitterVisible(ParticleEmitter* emitter, const Frustum& frustum, glm::vec3 cameraPosition)
+{
+	glm::vec3 boxMin, boxMax;
+	emitter->getBounds(boxMin, boxMax);
+
+	if (!frustum.intersects(boxMin, boxMax))
+		return false;
+
+	if (!_occlusionTest)
+		return true;
+
+	// hidden only if both the center and the top of the bounds are behind something
+	glm::vec3 center = (boxMin + boxMax) * 0.5f;
+	glm::vec3 top = glm::vec3(center.x, boxMax.y, center.z);
+	return !_occlusionTest(cameraPosition, center) || !_occlusionTest(cameraPosition, top);
+}
+
+void ParticleManager::Update(float deltaTime)
+{
+	PROFILE_SCOPE("particle update");
+	Frustum frustum(_camera->getProjectionMatrix() * _camera->GetViewMatrix());
+	glm::vec3 cameraPosition = _camera->getPosition();
+
+	_visibleEmitters.clear();
+	for (size_t i = 0; i < _emitters.size(); i++) {
+		ParticleEmitter* emitter = _emitters[i].get();
+		if (isEmitterVisible(emitter, frustum, cameraPosition)) {
+			_visibleEmitters.push_back(emitter);
+		}
+		else {
+			emitter->Hide(deltaTime);
+		}
+	}
+
+	_pool->parallelFor(_visibleEmitters.size(), [this, deltaTime, cameraPosition](size_t begin, size_t end) {
+		PROFILE_SCOPE("simulate emitters");
+		for (size_t i = begin; i < end; i++) {
+			ParticleEmitter* emitter = _visibleEmitters[i];
+			emitter->Simulate(deltaTime, emitter->getSettings().spawnCount, cameraPosition);
+		}
+	});
+}
+
+void ParticleManager::drawBlendMode(ParticleBlendMode mode)
+{
+	_drawOrder.clear();
+	unsigned int total = 0;
+	bool rotationFrame = false;
+	for (size_t i = 0; i < _emitters.size(); i++) {
+		ParticleEmitter* emitter = _emitters[i].get();
+		if (emitter->isVisible() && emitter->getSettings().blendMode == mode && emitter->getParticleCount() > 0) {
+			_drawOrder.push_back(emitter);
+			total += emitter->getParticleCount();
+			rotationFrame = rotationFrame || emitter->hasRotationFrame();
+		}
+	}
+
+	if (total == 0)
+		return;
+
+	// every emitter is sorted back to front already, for alpha blending the emitters themselves are ordered the same way
+	if (mode == PBLEND_ALPHA) {
+		glm::vec3 cameraPosition = _camera->getPosition();
+		std::sort(_drawOrder.begin(), _drawOrder.end(), [&cameraPosition](ParticleEmitter* a, ParticleEmitter* b) {
+			return glm::length2(a->getPosition() - cameraPosition) > glm::length2(b->getPosition() - cameraPosition);
+		});
+	}
+
+	if (total > _capacity) {
+		resizeBuffers(total);
+	}
+
+	unsigned int offset = 0;
+	for (size_t i = 0; i < _drawOrder.size(); i++) {
+		ParticleEmitter* emitter = _drawOrder[i];
+		unsigned int count = emitter->getParticleCount();
+		std::memcpy(&_instanceData[offset], emitter->getInstanceData(), count * sizeof(PackedParticle));
+
+		if (rotationFrame) {
+			if (emitter->hasRotationFrame())
+				std::memcpy(&_rotationFrameData[offset * 2], emitter->getRotationFrameData(), count * 2 * sizeof(uint16_t));
+			else
+				std::memset(&_rotationFrameData[offset * 2], 0, count * 2 * sizeof(uint16_t));
+		}
+		offset += count;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, _particles_instance_buffer);
+	gpuBufferData(PMEM_PARTICLES, GL_ARRAY_BUFFER, _particles_instance_buffer, _capacity * sizeof(PackedParticle), NULL, GL_STREAM_DRAW); // Buffer orphaning
+	glBufferSubData(GL_ARRAY_BUFFER, 0, total * sizeof(PackedParticle), _instanceData.data());
+
+	// the rotation/frame stream is only uploaded if somebody in this draw uses it
+	if (rotationFrame) {
+		glBindBuffer(GL_ARRAY_BUFFER, _particles_rotation_buffer);
+		gpuBufferData(PMEM_PARTICLES, GL_ARRAY_BUFFER, _particles_rotation_buffer, _capacity * 2 * sizeof(uint16_t), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, total * 2 * sizeof(uint16_t), _rotationFrameData.data());
+		glEnableVertexAttribArray(3);
+	}
+	else {
+		glDisableVertexAttribArray(3);
+		glVertexAttribI4ui(3, 0, 0, 0, 0);
+	}
+
+	if (mode == PBLEND_ADDITIVE) {
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	}
+	else {
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, total);
+}
+
+void ParticleManager::Draw()
+{
+	PROFILE_SCOPE("particle draw");
+	if (_vao == 0) {
+		init();
+	}
+
+	_shader->use();
+	_shader->setUniform(_viewProjectionLocation, _camera->getProjectionMatrix() * _camera->GetViewMatrix());
+	_shader->setUniform("view", _camera->GetViewMatrix());
+	_shader->setUniform("projection", _camera->getProjectionMatrix());
+	// every emitter packs relative to the camera position of the current frame
+	_shader->setUniform("cameraOrigin", _camera->getPosition());
+
+	glBindVertexArray(_vao);
+
+	for (int mode = 0; mode < PBLEND_COUNT; mode++) {
+		drawBlendMode(static_cast<ParticleBlendMode>(mode));
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// restore the default blending of the scene
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+unsigned int ParticleManager::getEmitterCount()
+{
+	return static_cast<unsigned int>(_emitters.size());
+}
+
+unsigned int ParticleManager::getVisibleEmitterCount()
+{
+	return static_cast<unsigned int>(_visibleEmitters.size());
+}
+
+unsigned int ParticleManager::getParticleCount()
+{
+	unsigned int count = 0;
+	for (size_t i = 0; i < _emitters.size(); i++) {
+		count += _emitters[i]->getParticleCount();
+	}
+	return count;
+}
+
+ParticleStats ParticleManager::getStats()
+{
+	ParticleStats stats;
+	for (size_t i = 0; i < _emitters.size(); i++) {
+		stats.add(_emitters[i]->getStats());
+	}
+	return stats;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include "ParticleEmitter.h"
+#include "Shader.h"
+#include "Camera.h"
+#include "ThreadPool.h"
+#include "Frustum.h"
+
+
+/*
+Owns all particle emitters of a level.
+The emitters are simulated in parallel on the thread pool, afterwards the packed
+instances of all emitters that share a blend mode are uploaded into one buffer
+and rendered with a single instanced draw call.
+*/
+class ParticleManager
+{
+
+private:
+	std::vector<std::unique_ptr<ParticleEmitter>> _emitters;
+
+	std::shared_ptr<Shader> _shader;
+	Camera* _camera;
+	ThreadPool* _pool;
+
+	//merged instance data of one blend mode, reused every frame
+	TrackedVector<PackedParticle, PMEM_PARTICLES> _instanceData;
+	TrackedVector<uint16_t, PMEM_PARTICLES> _rotationFrameData;
+	std::vector<ParticleEmitter*> _drawOrder;
+
+	//emitters that passed the culling this frame
+	std::vector<ParticleEmitter*> _visibleEmitters;
+
+	//returns true if the line between the two points is blocked, optional
+	std::function<bool(glm::vec3, glm::vec3)> _occlusionTest;
+
+	bool isEmitterVisible(ParticleEmitter* emitter, const Frustum& frustum, glm::vec3 cameraPosition);
+
+	unsigned int _capacity = 0;
+	GLuint _vao = 0;
+	GLuint _billboard_vertex_buffer = 0;
+	GLuint _particles_instance_buffer = 0;
+	GLuint _particles_rotation_buffer = 0;
+	//the name is too long for the small string buffer, setting it by name would allocate every frame
+	GLint _viewProjectionLocation = -1;
+
+	void init();
+	void resizeBuffers(unsigned int capacity);
+	void drawBlendMode(ParticleBlendMode mode);
+
+public:
+	ParticleManager(std::shared_ptr<Shader>& shader, Camera& cam, ThreadPool& pool);
+	~ParticleManager();
+
+	//creates a new emitter, the manager keeps ownership
+	ParticleEmitter* addEmitter(const EmitterSettings& settings);
+
+	//culls the emitters against the camera and simulates the visible ones, one emitter per task
+	void Update(float deltaTime);
+
+	//used to skip emitters that are hidden behind walls, gets the camera and a point of the emitter
+	void setOcclusionTest(std::function<bool(glm::vec3, glm::vec3)> occlusionTest);
+
+	//one instanced draw per blend mode
+	void Draw();
+
+	unsigned int getEmitterCount();
+	unsigned int getParticleCount();
+	unsigned int getVisibleEmitterCount();
+
+	//sum of the stats of all emitters
+	ParticleStats getStats();
+};
@@ -0,0 +1,98 @@
+#include "PatrolEnemies.h"
+
+using namespace physx;
+
+
+//enemies per task, one enemy is only a few vector operations
+static const size_t PATROL_GRAIN = 64;
+
+
+size_t PatrolEnemies::add(PxRigidDynamic& actor, const std::vector<PxVec3>& path, float speed)
+{
+	PxVec3 forward = path.size() > 1 ? (path[1] - path[0]).getNormalized() : PxVec3(0.0f, 0.0f, 1.0f);
+	PxTransform pose = actor.getGlobalPose();
+
+	_actors.push_back(&actor);
+	_pathStart.push_back(static_cast<uint32_t>(_pathPoints.size()));
+	_pathLength.push_back(static_cast<uint32_t>(path.size()));
+	_pathPoints.insert(_pathPoints.end(), path.begin(), path.end());
+	_cursor.push_back(0);
+	_speed.push_back(speed);
+	_forward.push_back(forward.isZero() ? PxVec3(0.0f, 0.0f, 1.0f) : forward);
+
+	_previousPoses.push_back(pose);
+	_currentPoses.push_back(pose);
+	_targets.push_back(pose);
+	return _actors.size() - 1;
+}
+
+size_t PatrolEnemies::size() const
+{
+	return _actors.size();
+}
+
+void PatrolEnemies::update(float deltaTime, ThreadPool& pool)
+{
+	pool.parallelFor(_actors.size(), [this, deltaTime](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (_pathLength[i] == 0)
+				continue;
+
+			PxVec3 position = _currentPoses[i].p;
+			PxVec3 point = _pathPoints[_pathStart[i] + _cursor[i]];
+			PxVec3 heading = point - position;
+			float distance = heading.magnitude();
+			float stepLength = _speed[i] * deltaTime;
+			PxQuat rotation = _currentPoses[i].q;
+
+			if (distance > 0.0001f) {
+				heading /= distance;
+
+				// turn from the first leg of the path to where the enemy is heading
+				float dot = _forward[i].dot(heading);
+				PxVec3 axis = _forward[i].cross(heading);
+				if (axis.magnitude() > 0.0001f)
+					rotation = PxQuat(PxAcos(PxClamp(dot, -1.0f, 1.0f)), axis.getNormalized());
+				else
+					rotation = dot > 0.0f ? PxQuat(PxIdentity) : PxQuat(PxPi, PxVec3(0.0f, 1.0f, 0.0f));
+			}
+
+			// stop on the point instead of overshooting it, the next step heads for the following one
+			if (distance <= stepLength) {
+				position = point;
+				_cursor[i] = (_cursor[i] + 1) % _pathLength[i];
+			}
+			else {
+				position += heading * stepLength;
+			}
+
+			_targets[i] = PxTransform(position, rotation);
+		}
+	}, PATROL_GRAIN);
+
+	// the scene does not take writes from several threads, all targets go in from here
+	for (size_t i = 0; i < _actors.size(); i++) {
+		_actors[i]->setKinematicTarget(_targets[i]);
+	}
+}
+
+void PatrolEnemies::finishStep()
+{
+	_previousPoses.swap(_currentPoses);
+	_currentPoses = _targets;
+}
+
+PxRigidDynamic* PatrolEnemies::getActor(size_t index) const
+{
+	return _actors[index];
+}
+
+const std::vector<PxTransform>& PatrolEnemies::getPreviousPoses() const
+{
+	return _previousPoses;
+}
+
+const std::vector<PxTransform>& PatrolEnemies::getCurrentPoses() const
+{
+	return _currentPoses;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "PxPhysicsAPI.h"
+#include "ThreadPool.h"
+
+
+/*
+All enemies that walk along a closed path, stored as structure of arrays.
+The control points of every path live in one flat buffer, each enemy only keeps
+where its slice starts, how long it is and which point it walks to next.
+Poses are cached: a kinematic actor ends a step exactly on its target, so the
+scene is never asked where an enemy is.
+*/
+class PatrolEnemies
+{
+private:
+	std::vector<physx::PxVec3> _pathPoints;
+
+	std::vector<physx::PxRigidDynamic*> _actors;
+	std::vector<uint32_t> _pathStart;
+	std::vector<uint32_t> _pathLength;
+	std::vector<uint32_t> _cursor;
+	std::vector<float> _speed;
+	//direction the model faces without rotation, the first leg of the path
+	std::vector<physx::PxVec3> _forward;
+
+	//poses after the last two finished steps and the one the running step moves to
+	std::vector<physx::PxTransform> _previousPoses;
+	std::vector<physx::PxTransform> _currentPoses;
+	std::vector<physx::PxTransform> _targets;
+
+public:
+	//the enemy starts at the current pose of the actor and walks to the first point of the path, speed in units per second
+	size_t add(physx::PxRigidDynamic& actor, const std::vector<physx::PxVec3>& path, float speed = 1.0f);
+
+	size_t size() const;
+
+	//moves every enemy along its path in parallel and hands all kinematic targets to the scene afterwards
+	void update(float deltaTime, ThreadPool& pool);
+
+	//called once the step that moved to the targets was fetched
+	void finishStep();
+
+	physx::PxRigidDynamic* getActor(size_t index) const;
+	const std::vector<physx::PxTransform>& getPreviousPoses() const;
+	const std::vector<physx::PxTransform>& getCurrentPoses() const;
+};
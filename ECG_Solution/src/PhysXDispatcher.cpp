@@ -0,0 +1,21 @@
+#include "PhysXDispatcher.h"
+
+
+PhysXDispatcher::PhysXDispatcher(ThreadPool& pool)
+	: _pool(&pool)
+{
+}
+
+void PhysXDispatcher::submitTask(physx::PxBaseTask& task)
+{
+	physx::PxBaseTask* pending = &task;
+	_pool->submit([pending] {
+		pending->run();
+		pending->release();
+	});
+}
+
+uint32_t PhysXDispatcher::getWorkerCount() const
+{
+	return _pool->getWorkerCount();
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "PxPhysicsAPI.h"
+#include "ThreadPool.h"
+
+
+/*
+CPU dispatcher that hands the PhysX tasks to the engine thread pool,
+so physics shares its threads with the rest of the engine instead of starting its own.
+*/
+class PhysXDispatcher : public physx::PxCpuDispatcher
+{
+private:
+	ThreadPool* _pool;
+
+public:
+	PhysXDispatcher(ThreadPool& pool);
+
+	//runs the task on a worker and releases it afterwards, like the PhysX default dispatcher does
+	void submitTask(physx::PxBaseTask& task) override;
+
+	//PhysX splits its work into about this many tasks
+	uint32_t getWorkerCount() const override;
+};
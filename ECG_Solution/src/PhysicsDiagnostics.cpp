@@ -0,0 +1,154 @@
+#include "PhysicsDiagnostics.h"
+#include <sstream>
+#include <algorithm>
+
+using namespace physx;
+
+
+//a zone that is still open on this thread, PhysX nests them per thread
+struct ThreadZone {
+	PhysicsProfiler* owner;
+	const char* name;
+	std::chrono::steady_clock::time_point start;
+	void* nextData;
+};
+
+static thread_local std::vector<ThreadZone> openZones;
+
+
+unsigned int parsePhysicsDiagnostics(const std::string& list)
+{
+	unsigned int flags = PDIAG_NONE;
+	std::stringstream stream(list);
+	std::string name;
+
+	while (std::getline(stream, name, ',')) {
+		name.erase(0, name.find_first_not_of(" \t"));
+		name.erase(name.find_last_not_of(" \t") + 1);
+
+		if (name == "pvd_file")
+			flags |= PDIAG_PVD_FILE;
+		else if (name == "pvd_socket")
+			flags |= PDIAG_PVD_SOCKET;
+		else if (name == "profiler")
+			flags |= PDIAG_PROFILER;
+		else if (name == "counters")
+			flags |= PDIAG_COUNTERS;
+	}
+	return flags;
+}
+
+
+PhysicsProfiler::PhysicsProfiler(PxProfilerCallback* next)
+	: _next(next)
+{
+}
+
+void* PhysicsProfiler::zoneStart(const char* eventName, bool detached, uint64_t contextId)
+{
+	OpenZone zone;
+	zone.name = eventName;
+	zone.nextData = _next ? _next->zoneStart(eventName, detached, contextId) : nullptr;
+	zone.start = Clock::now();
+
+	if (detached) {
+		std::lock_guard<std::mutex> lock(_detachedMutex);
+		_detachedZones.insert(std::make_pair(std::make_pair(eventName, contextId), zone));
+		return nullptr;
+	}
+
+	ThreadZone open = { this, eventName, zone.start, zone.nextData };
+	openZones.push_back(open);
+	return nullptr;
+}
+
+void PhysicsProfiler::zoneEnd(void* profilerData, const char* eventName, bool detached, uint64_t contextId)
+{
+	PX_UNUSED(profilerData);
+
+	OpenZone zone;
+
+	if (detached) {
+		std::lock_guard<std::mutex> lock(_detachedMutex);
+		auto it = _detachedZones.find(std::make_pair(eventName, contextId));
+		if (it == _detachedZones.end())
+			return;
+		zone = it->second;
+		_detachedZones.erase(it);
+	}
+	else {
+		// zones close in reverse order, anything above the matching one was left open by mistake
+		size_t i = openZones.size();
+		while (i > 0 && (openZones[i - 1].owner != this || openZones[i - 1].name != eventName))
+			i--;
+		if (i == 0)
+			return;
+
+		zone.name = eventName;
+		zone.start = openZones[i - 1].start;
+		zone.nextData = openZones[i - 1].nextData;
+		openZones.resize(i - 1);
+	}
+
+	if (_next)
+		_next->zoneEnd(zone.nextData, eventName, detached, contextId);
+	closeZone(zone);
+}
+
+void PhysicsProfiler::closeZone(const OpenZone& zone)
+{
+	Clock::time_point end = Clock::now();
+	if (_sink)
+		_sink(zone.name, zone.start, end);
+
+	double ms = std::chrono::duration<double, std::milli>(end - zone.start).count();
+
+	std::lock_guard<std::mutex> lock(_totalsMutex);
+	PhysicsZoneTotal& total = _totals[zone.name];
+	total.name = zone.name;
+	total.totalMs += ms;
+	total.count++;
+}
+
+void PhysicsProfiler::setSink(ZoneSink sink)
+{
+	_sink = sink;
+}
+
+std::vector<PhysicsZoneTotal> PhysicsProfiler::takeTotals()
+{
+	std::vector<PhysicsZoneTotal> totals;
+	{
+		std::lock_guard<std::mutex> lock(_totalsMutex);
+		for (auto it = _totals.begin(); it != _totals.end(); ++it)
+			totals.push_back(it->second);
+		_totals.clear();
+	}
+
+	std::sort(totals.begin(), totals.end(), [](const PhysicsZoneTotal& a, const PhysicsZoneTotal& b) {
+		return a.totalMs > b.totalMs;
+	});
+	return totals;
+}
+
+
+void* TrackedPhysXAllocator::allocate(size_t size, const char* typeName, const char* filename, int line)
+{
+	char* block = static_cast<char*>(_allocator.allocate(size + HEADER_SIZE, typeName, filename, line));
+	if (!block)
+		return nullptr;
+
+	*reinterpret_cast<size_t*>(block) = size;
+	MemoryTracker::get().allocate(PMEM_PHYSICS, PMEM_RAM, size);
+	return block + HEADER_SIZE;
+}
+
+void TrackedPhysXAllocator::deallocate(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	char* block = static_cast<char*>(ptr) - HEADER_SIZE;
+	MemoryTracker::get().release(PMEM_PHYSICS, PMEM_RAM, *reinterpret_cast<size_t*>(block));
+	_allocator.deallocate(block);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include "PxPhysicsAPI.h"
+#include "MemoryTracker.h"
+
+
+//what the physics world records, any combination, PDIAG_NONE costs nothing
+enum PhysicsDiagnosticsFlag {
+
+	PDIAG_NONE = 0,
+	//PhysX Visual Debugger capture written to a file
+	PDIAG_PVD_FILE = 1 << 0,
+	//PhysX Visual Debugger connected over the network, needs a running PVD
+	PDIAG_PVD_SOCKET = 1 << 1,
+	//PhysX profile zones, collected per zone name
+	PDIAG_PROFILER = 1 << 2,
+	//per step counters and timings
+	PDIAG_COUNTERS = 1 << 3
+};
+
+//reads a comma separated list like "pvd_file, counters", unknown names are ignored
+unsigned int parsePhysicsDiagnostics(const std::string& list);
+
+//what happened during the last finished step
+struct PhysicsStepCounters {
+
+	unsigned int activeDynamics = 0;
+	unsigned int activeKinematics = 0;
+	//pairs after the broad phase and the ones of them that actually touch
+	unsigned int pairs = 0;
+	unsigned int touchingPairs = 0;
+	unsigned int newTouches = 0;
+	unsigned int lostTouches = 0;
+	unsigned int constraints = 0;
+
+	//player, perception and enemy updates before simulate, in ms
+	float gameplayMs = 0.0f;
+	//time spent in simulate before it returned, time blocked in fetchResults and from the start of the step until it was collected, in ms
+	float simulateMs = 0.0f;
+	float fetchMs = 0.0f;
+	float stepMs = 0.0f;
+};
+
+//time spent in one kind of PhysX zone
+struct PhysicsZoneTotal {
+
+	const char* name = nullptr;
+	double totalMs = 0.0;
+	unsigned int count = 0;
+};
+
+/*
+Profiler callback that receives the profile zones of the PhysX SDK.
+The zones are summed up per name and handed to an optional sink, so they can end
+up in the engine profiler. A callback that was installed before (the PVD when it
+profiles) keeps receiving every zone as well.
+Zones are only emitted by PhysX libraries that are built with profiling.
+*/
+class PhysicsProfiler : public physx::PxProfilerCallback
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	//name of the zone, when it started and when it ended
+	typedef std::function<void(const char*, Clock::time_point, Clock::time_point)> ZoneSink;
+
+private:
+	struct OpenZone {
+		const char* name;
+		Clock::time_point start;
+		void* nextData;
+	};
+
+	physx::PxProfilerCallback* _next;
+	ZoneSink _sink;
+
+	//detached zones end on a different thread than they started on
+	std::mutex _detachedMutex;
+	std::multimap<std::pair<const char*, uint64_t>, OpenZone> _detachedZones;
+
+	std::mutex _totalsMutex;
+	std::map<const char*, PhysicsZoneTotal> _totals;
+
+	void closeZone(const OpenZone& zone);
+
+public:
+	PhysicsProfiler(physx::PxProfilerCallback* next);
+
+	void* zoneStart(const char* eventName, bool detached, uint64_t contextId) override;
+	void zoneEnd(void* profilerData, const char* eventName, bool detached, uint64_t contextId) override;
+
+	//called for every zone that ends, from the thread that ends it
+	void setSink(ZoneSink sink);
+
+	//summed up zones since the last call, the most expensive first
+	std::vector<PhysicsZoneTotal> takeTotals();
+};
+
+/*
+Allocator of the PhysX foundation that counts everything the SDK allocates as physics RAM.
+The size is kept in front of every block since deallocate does not get it, the header
+is 16 bytes so the blocks stay 16 byte aligned as PhysX requires.
+*/
+class TrackedPhysXAllocator : public physx::PxAllocatorCallback
+{
+private:
+	static const size_t HEADER_SIZE = 16;
+
+	physx::PxDefaultAllocator _allocator;
+
+public:
+	void* allocate(size_t size, const char* typeName, const char* filename, int line) override;
+	void deallocate(void* ptr) override;
+};
@@ -1,28 +1,52 @@
 #include "PhysicsWorld.h"
 #include "Timer.h"
+#include "PhysXDispatcher.h"
+#include "FrameProfiler.h"
 #include <ctime>
+#include <iostream>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtx/quaternion.hpp>
 
 
+// the distance from the player at which the old checks fired, minus half the width of the player
+static const float BALL_HIT_RADIUS = 2.0f;
+static const float ENEMY_HIT_RADIUS = 2.5f;
+static const float KEY_PICKUP_RADIUS = 1.5f;
+
+// how far patroling enemies see, and how far ahead the ball checks its way
+static const float PATROL_SIGHT_RANGE = 20.0f;
+static const float CHASER_LOOKAHEAD = 1.0f;
+
+
 
 PhysicsWorld::PhysicsWorld() {}
 
-void PhysicsWorld::initPhysics() {
+void PhysicsWorld::initPhysics(ThreadPool& pool, unsigned int diagnostics, const std::string& pvdFile) {
 
+	_pool = &pool;
 	gFoundation = PxCreateFoundation(PX_PHYSICS_VERSION, gAllocator, gErrorCallback);
 
-	gPvd = PxCreatePvd(*gFoundation);
-	PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate("127.0.0.1", 5425, 10);
-	gPvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
+	// the visual debugger is only created when asked for, connecting and instrumenting every step is not free
+	if (diagnostics & (PDIAG_PVD_FILE | PDIAG_PVD_SOCKET)) {
+		gPvd = PxCreatePvd(*gFoundation);
+		if (diagnostics & PDIAG_PVD_FILE)
+			gTransport = PxDefaultPvdFileTransportCreate(pvdFile.c_str());
+		else
+			gTransport = PxDefaultPvdSocketTransportCreate("127.0.0.1", 5425, 10);
+		gPvd->connect(*gTransport, PxPvdInstrumentationFlag::eALL);
+	}
 
-	gPhysics = PxCreatePhysics(PX_PHYSICS_VERSION, *gFoundation, PxTolerancesScale(), true, gPvd);
+	gPhysics = PxCreatePhysics(PX_PHYSICS_VERSION, *gFoundation, PxTolerancesScale(), gPvd != nullptr, gPvd);
 
 	PxSceneDesc sceneDesc(gPhysics->getTolerancesScale());
 	sceneDesc.gravity = PxVec3(0.0f,-9.81f, 0.0f);
-	gDispatcher = PxDefaultCpuDispatcherCreate(2);
+	gDispatcher = new PhysXDispatcher(pool);
 	sceneDesc.cpuDispatcher = gDispatcher;
-	sceneDesc.filterShader = PxDefaultSimulationFilterShader;
+	sceneDesc.filterShader = gameplayFilterShader;
+	sceneDesc.simulationEventCallback = &gEvents;
+	// the player controller and the patrol enemies are kinematic, their triggers have to reach the filter shader
+	sceneDesc.kineKineFilteringMode = PxPairFilteringMode::eKEEP;
+	sceneDesc.staticKineFilteringMode = PxPairFilteringMode::eKEEP;
 	gScene = gPhysics->createScene(sceneDesc);
 	PxTolerancesScale scale;
 	scale.length = 3;        // typical length of an object
@@ -31,7 +55,7 @@ void PhysicsWorld::initPhysics() {
 	//must be set on the scene for the active actors array to be generated.
 	PxSceneFlag::eENABLE_ACTIVE_ACTORS;
 
-	PxPvdSceneClient* pvdClient = gScene->getScenePvdClient();
+	PxPvdSceneClient* pvdClient = gPvd ? gScene->getScenePvdClient() : nullptr;
 	if (pvdClient)
 	{
 		pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_CONSTRAINTS, true);
@@ -44,10 +68,93 @@ void PhysicsWorld::initPhysics() {
 	//gScene->addActor(*groundPlane);
 
 	gManager = PxCreateControllerManager(*gScene);
+
+	gStaticColliders = new StaticColliderBuilder(*gPhysics, *gMaterial);
+	gCollisionMeshes = new CollisionMeshCache(*gFoundation, *gPhysics, "assets/cache/");
+
+	_diagnostics = diagnostics & (PDIAG_PVD_FILE | PDIAG_PVD_SOCKET);
+	setDiagnostics(diagnostics);
+}
+
+void PhysicsWorld::setDiagnostics(unsigned int diagnostics) {
+
+	// nothing may run while the profiler is swapped
+	finishSimulation();
+
+	if ((diagnostics & PDIAG_PROFILER) && !gProfiler) {
+		// whoever profiled before (the PVD) keeps getting the zones through ours
+		gPreviousProfiler = PxGetProfilerCallback();
+		gProfiler = new PhysicsProfiler(gPreviousProfiler);
+		PxSetProfilerCallback(gProfiler);
+	}
+	else if (!(diagnostics & PDIAG_PROFILER) && gProfiler) {
+		PxSetProfilerCallback(gPreviousProfiler);
+		delete gProfiler;
+		gProfiler = nullptr;
+	}
+
+	if (!(diagnostics & PDIAG_COUNTERS)) {
+		_stepCounters = PhysicsStepCounters();
+	}
+
+	unsigned int pvd = PDIAG_PVD_FILE | PDIAG_PVD_SOCKET;
+	_diagnostics = (_diagnostics & pvd) | (diagnostics & ~pvd);
+}
+
+
+unsigned int PhysicsWorld::getDiagnostics() {
+	return _diagnostics;
+}
+
+
+const PhysicsStepCounters& PhysicsWorld::getStepCounters() {
+	return _stepCounters;
+}
+
+
+PhysicsProfiler* PhysicsWorld::getProfiler() {
+	return gProfiler;
+}
+
+
+void PhysicsWorld::closeDiagnostics() {
+
+	finishSimulation();
+
+	if (gProfiler) {
+		std::vector<PhysicsZoneTotal> totals = gProfiler->takeTotals();
+		std::cout << "PhysX zones:" << std::endl;
+		for (size_t i = 0; i < totals.size(); i++) {
+			std::cout << "  " << totals[i].name << ": " << totals[i].totalMs << " ms in " << totals[i].count << " calls" << std::endl;
+		}
+	}
+
+	// the file transport writes the rest of the capture when it is disconnected
+	if (gPvd && gPvd->isConnected()) {
+		gPvd->disconnect();
+	}
 }
 
 void PhysicsWorld::setKeyPosition(PxVec3 position) {
 	keyPosition = position;
+
+	if (pKeyTrigger) {
+		pKeyTrigger->setGlobalPose(PxTransform(position));
+		return;
+	}
+	pKeyTrigger = gPhysics->createRigidStatic(PxTransform(position));
+	attachTrigger(*pKeyTrigger, KEY_PICKUP_RADIUS, PFILTER_PICKUP);
+	gScene->addActor(*pKeyTrigger);
+}
+
+
+void PhysicsWorld::attachTrigger(PxRigidActor& actor, float radius, PhysicsFilterGroup group) {
+
+	// not part of the simulation and invisible to raycasts and the character controller
+	PxShape* trigger = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial, true, PxShapeFlag::eVISUALIZATION | PxShapeFlag::eTRIGGER_SHAPE);
+	trigger->setSimulationFilterData(PxFilterData(group, PFILTER_PLAYER, 0, 0));
+	actor.attachShape(*trigger);
+	trigger->release();
 }
 
 
@@ -56,6 +163,14 @@ PxScene* PhysicsWorld::getScene() {
 }
 
 
+void PhysicsWorld::buildStaticColliders() {
+
+	if (gStaticColliders->hasPending()) {
+		gStaticColliders->build(*gScene, pStaticObjects);
+	}
+}
+
+
 /*
 * createShape takes the volume
 * PxTransform the position
@@ -66,19 +181,14 @@ void PhysicsWorld::addCubeToPWorld(Geometry& obj, glm::vec3 measurements, bool i
 
 	PxVec3 position = OwnUtils::glmModelMatrixToPxVec3(obj.getModelMatrix());
 	
-	PxShape* tmpShape = gPhysics->createShape(PxBoxGeometry(measurements.x, measurements.y, measurements.z), *gMaterial);
-
-	//add the object to the physx object
+	//add the object to the physx object, statics are created in bulk by buildStaticColliders
 	if (isStatic) {
 		if (!isTorchHitbox)
 		{
 			gObjects.push_back(&obj);
 		}
 		PxTransform x = PxTransform(position, PxQuat(OwnUtils::getOriMat(obj.getModelMatrix())));
-		PxRigidStatic* cube = PxCreateStatic(*gPhysics, x , *tmpShape);
-		cube->userData = (void*)&obj;
-		gScene->addActor(*cube);
-		pStaticObjects.push_back(cube);
+		gStaticColliders->addBox(x, PxVec3(measurements.x, measurements.y, measurements.z), (void*)&obj);
 	}
 	//this sets the player, it is going to be the only dynamic cube in our world
 	// disabling x and z axis for not falling over
@@ -87,6 +197,7 @@ void PhysicsWorld::addCubeToPWorld(Geometry& obj, glm::vec3 measurements, bool i
 		PxMaterial* playerMaterial = gPhysics->createMaterial(0.5f, 0.5f, 0.0f);
 		PxShape* playerShape = gPhysics->createShape(PxBoxGeometry(measurements.x, measurements.y, measurements.z), *playerMaterial);
 		PxRigidDynamic* playerHitbox = PxCreateDynamic(*gPhysics, PxTransform(position), *playerShape, 1);
+		playerShape->release(); // the actor holds the shape now
 		playerHitbox->userData = (void*)&obj;	
 		playerHitbox->setRigidDynamicLockFlag(PxRigidDynamicLockFlag::eLOCK_ANGULAR_Z, true);
 		playerHitbox->setRigidDynamicLockFlag(PxRigidDynamicLockFlag::eLOCK_ANGULAR_X, true);
@@ -103,19 +214,14 @@ void PhysicsWorld::addCubeToPWorld(Model& obj, glm::vec3 measurements, bool isSt
 
 	PxVec3 position = OwnUtils::glmModelMatrixToPxVec3(obj.getModel());
 
-	PxShape* tmpShape = gPhysics->createShape(PxBoxGeometry(measurements.x, measurements.y, measurements.z), *gMaterial);
-
-	//add the object to the physx object
+	//add the object to the physx object, statics are created in bulk by buildStaticColliders
 	if (isStatic) {
 		if (!isTorchHitbox)
 		{
 			gModels.push_back(&obj);
 		}
 		PxTransform x = PxTransform(position, PxQuat(OwnUtils::getOriMat(obj.getModel())));
-		PxRigidStatic* cube = PxCreateStatic(*gPhysics, x, *tmpShape);
-		cube->userData = (void*)&obj;
-		gScene->addActor(*cube);
-		pStaticObjects.push_back(cube);
+		gStaticColliders->addBox(x, PxVec3(measurements.x, measurements.y, measurements.z), (void*)&obj);
 	}
 	//this sets the player, it is going to be the only dynamic cube in our world
 	// disabling x and z axis for not falling over
@@ -125,6 +231,7 @@ void PhysicsWorld::addCubeToPWorld(Model& obj, glm::vec3 measurements, bool isSt
 		PxMaterial* playerMaterial = gPhysics->createMaterial(0.5f, 0.5f, 0.0f);
 		PxShape* playerShape = gPhysics->createShape(PxBoxGeometry(measurements.x, measurements.y, measurements.z), *playerMaterial);
 		PxRigidDynamic* playerHitbox = PxCreateDynamic(*gPhysics, PxTransform(position), *playerShape, 1);
+		playerShape->release(); // the actor holds the shape now
 		playerHitbox->userData = (void*)&obj;
 		playerHitbox->setRigidDynamicLockFlag(PxRigidDynamicLockFlag::eLOCK_ANGULAR_Z, true);
 		playerHitbox->setRigidDynamicLockFlag(PxRigidDynamicLockFlag::eLOCK_ANGULAR_X, true);
@@ -136,6 +243,54 @@ void PhysicsWorld::addCubeToPWorld(Model& obj, glm::vec3 measurements, bool isSt
 	}
 }
 
+bool PhysicsWorld::addMeshToPWorld(Model& obj, CollisionMeshType type) {
+
+	PxBase* mesh = type == PCONVEX ? static_cast<PxBase*>(gCollisionMeshes->getConvexMesh(obj)) : gCollisionMeshes->getTriangleMesh(obj);
+	if (!addStaticMesh(mesh, obj.getModel(), (void*)&obj))
+		return false;
+
+	gModels.push_back(&obj);
+	return true;
+}
+
+bool PhysicsWorld::addCachedMeshToPWorld(uint64_t sourceHash, glm::mat4 transform) {
+
+	return addStaticMesh(gCollisionMeshes->getCachedMesh(sourceHash), transform, nullptr);
+}
+
+bool PhysicsWorld::addStaticMesh(PxBase* mesh, glm::mat4 modelMatrix, void* userData) {
+
+	if (!mesh)
+		return false;
+
+	// PhysX wants the scale of the model matrix in the geometry and a pure rotation in the pose
+	glm::vec3 scale = glm::vec3(glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])));
+	glm::mat4 rotationMatrix = modelMatrix;
+	rotationMatrix[0] /= scale.x;
+	rotationMatrix[1] /= scale.y;
+	rotationMatrix[2] /= scale.z;
+
+	PxMeshScale meshScale(PxVec3(scale.x, scale.y, scale.z));
+	PxShape* shape = nullptr;
+
+	if (PxConvexMesh* convex = mesh->is<PxConvexMesh>())
+		shape = gPhysics->createShape(PxConvexMeshGeometry(convex, meshScale), *gMaterial);
+	else if (PxTriangleMesh* triangles = mesh->is<PxTriangleMesh>())
+		shape = gPhysics->createShape(PxTriangleMeshGeometry(triangles, meshScale), *gMaterial);
+
+	if (!shape)
+		return false;
+
+	PxTransform x = PxTransform(OwnUtils::glmModelMatrixToPxVec3(modelMatrix), PxQuat(OwnUtils::getOriMat(rotationMatrix)));
+	PxRigidStatic* actor = PxCreateStatic(*gPhysics, x, *shape);
+	shape->release();
+	actor->userData = userData;
+	gScene->addActor(*actor);
+	pStaticObjects.push_back(actor);
+	return true;
+}
+
+
 void PhysicsWorld::addPlayerToPWorld(Player& player, glm::vec3 measurements) {
 
 	PxBoxControllerDesc desc;
@@ -147,6 +302,14 @@ void PhysicsWorld::addPlayerToPWorld(Player& player, glm::vec3 measurements) {
 	desc.material = gMaterial;
 	desc.userData = (void*)&player;
 	controllerPlayer = gManager->createController(desc);
+
+	// the kinematic actor of the controller is what the triggers of enemies and pickups report
+	PxRigidDynamic* actor = controllerPlayer->getActor();
+	PxShape* shape;
+	for (PxU32 i = 0; i < actor->getNbShapes(); i++) {
+		actor->getShapes(&shape, 1, i);
+		shape->setSimulationFilterData(PxFilterData(PFILTER_PLAYER, PFILTER_ENEMY | PFILTER_PICKUP, 0, 0));
+	}
 }
 
 
@@ -154,190 +317,273 @@ void PhysicsWorld::addSphereToPWorld(Geometry& obj, float radius, bool isStatic)
 
 	gObjects.push_back(&obj);
 	PxVec3 position = OwnUtils::glmModelMatrixToPxVec3(obj.getModelMatrix());
-	PxShape* tmpShape = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial);
 
 	if (isStatic) {
+		PxShape* tmpShape = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial);
 		PxRigidStatic* sphere = PxCreateStatic(*gPhysics, PxTransform(position), *tmpShape);
+		tmpShape->release();
 		sphere->userData = (void*)&obj;
 		gScene->addActor(*sphere);
 		pStaticObjects.push_back(sphere);
 	}
 	else {
-		PxRigidDynamic* Enemy = PxCreateDynamic(*gPhysics, PxTransform(position), *tmpShape, 1);
-		pTestEnemy = Enemy;
-		Enemy->setAngularVelocity(PxVec3(0.5f, 0.5f, 0.5f));
-		Enemy->userData = (void*)&obj;
-		Enemy->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, true);
-		gScene->addActor(*Enemy);
-		pDynamicObjects.push_back(Enemy);
+		addChaser(glm::vec3(position.x, position.y, position.z), radius);
+		pTestEnemy->userData = (void*)&obj;
 	}
 }
 
 
-void PhysicsWorld::addSphereToPWorld(Model& obj, float radius, bool isStatic) {
+void PhysicsWorld::addStaticBox(glm::mat4 transform, glm::vec3 halfExtents) {
 
-	gModels.push_back(&obj);
-	PxVec3 position = OwnUtils::glmModelMatrixToPxVec3(obj.getModel());
-	PxShape* tmpShape = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial);
+	PxTransform x = PxTransform(OwnUtils::glmModelMatrixToPxVec3(transform), PxQuat(OwnUtils::getOriMat(transform)));
+	gStaticColliders->addBox(x, PxVec3(halfExtents.x, halfExtents.y, halfExtents.z), nullptr);
+}
 
-	if (isStatic) {
-		PxRigidStatic* sphere = PxCreateStatic(*gPhysics, PxTransform(position), *tmpShape);
-		sphere->userData = (void*)&obj;
-		gScene->addActor(*sphere);
-		pStaticObjects.push_back(sphere);
-	}
-	
-	else {
 
-		PxRigidDynamic* Enemy = PxCreateDynamic(*gPhysics, PxTransform(position), *tmpShape, 1);
-		pTestEnemy = Enemy;
-		Enemy->setAngularVelocity(PxVec3(0.5f, 0.5f, 0.5f));
-		Enemy->userData = (void*)&obj;
-		Enemy->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, true);
-		gScene->addActor(*Enemy);
-		pDynamicObjects.push_back(Enemy);
-	}
+void PhysicsWorld::addChaser(glm::vec3 position, float radius) {
+
+	PxShape* tmpShape = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial);
+	tmpShape->setSimulationFilterData(PxFilterData(PFILTER_ENEMY, PFILTER_PLAYER, 0, 0));
+	PxRigidDynamic* Enemy = PxCreateDynamic(*gPhysics, PxTransform(PxVec3(position.x, position.y, position.z)), *tmpShape, 1);
+	tmpShape->release();
+	pTestEnemy = Enemy;
+	_chaserRadius = radius;
+	_chaserTarget = Enemy->getGlobalPose().p;
+	Enemy->setAngularVelocity(PxVec3(0.5f, 0.5f, 0.5f));
+	Enemy->userData = nullptr;
+	Enemy->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, true);
+	attachTrigger(*Enemy, BALL_HIT_RADIUS, PFILTER_ENEMY);
+	gScene->addActor(*Enemy);
+	pDynamicObjects.push_back(Enemy);
+
+	_chaserBody = _renderPoses.size();
+	_renderPoses.push_back(glm::translate(glm::mat4(1.0f), position));
 }
 
 
-void PhysicsWorld::addEnemyToPWorld(Model& obj, Enemy& enem, float radius) {
+size_t PhysicsWorld::addPatrolEnemy(glm::vec3 position, float radius, const std::vector<PxVec3>& path) {
 
-	//Model
-	gModels.push_back(&obj);
-	PxVec3 position = OwnUtils::glmModelMatrixToPxVec3(obj.getModel());
 	PxShape* tmpShape = gPhysics->createShape(PxSphereGeometry(radius), *gMaterial);
 
-	//Enemy
-	movingEnemies.push_back(&enem);
-
 	//add the object to the physx object
-	PxRigidDynamic* dyn = PxCreateDynamic(*gPhysics, PxTransform(position), *tmpShape, 1);
-	dyn->userData = (void*)&obj;
+	PxRigidDynamic* dyn = PxCreateDynamic(*gPhysics, PxTransform(PxVec3(position.x, position.y, position.z)), *tmpShape, 1);
+	tmpShape->release();
+	dyn->userData = nullptr;
 	dyn->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, true);
 	dyn->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, true);
+	attachTrigger(*dyn, ENEMY_HIT_RADIUS, PFILTER_ENEMY);
 	gScene->addActor(*dyn);
-	enemyDynamics.push_back(dyn);
+
+	_patrolBodies.push_back(_renderPoses.size());
+	_renderPoses.push_back(glm::translate(glm::mat4(1.0f), position));
+	return gPatrols.add(*dyn, path);
 }
 
 
-void PhysicsWorld::updatePlayer(Movement movement, float deltaTime) {
+size_t PhysicsWorld::getChaserBody() {
+	return _chaserBody;
+}
 
-	static bool airborne = false;
-	static bool gravityEnabled = true;
 
-	static Timer JumpTimer = Timer();
-	
-	static float velocity = 0.f;
-	float gravity = -9.81f;
+size_t PhysicsWorld::getPatrolBody(size_t index) {
+	return _patrolBodies[index];
+}
 
-	// Update gravity effect if airborne
-	if (airborne) {
-		velocity += gravity * deltaTime; // Properly scale velocity by deltaTime
-	}
-	else {
-		velocity = 0; // Reset velocity if not airborne
-	}
+
+const std::vector<glm::mat4>& PhysicsWorld::getRenderPoses() {
+	return _renderPoses;
+}
 
 
+void PhysicsWorld::setFixedTimestep(float timestep, unsigned int maxSubsteps) {
 
-	Player* playerObject = (Player*)controllerPlayer->getUserData();
-	Camera* playerCamera = playerObject->getCamera();
+	_fixedTimestep = timestep > 0.0f ? timestep : 1.0f / 60.0f;
+	_maxSubsteps = maxSubsteps > 0 ? maxSubsteps : 1;
+}
 
-	glm::vec3 frontVector = playerCamera->getFront();
-	PxVec3 forward = PxVec3(frontVector.x, 0, frontVector.z).getNormalized() * deltaTime * 12.f;
-	PxVec3 backward = PxVec3(-frontVector.x, 0, -frontVector.z).getNormalized() * deltaTime * 12.f;
 
-	glm::vec3 rightVector = playerCamera->getRight();
-	PxVec3 right = PxVec3(rightVector.x, 0, rightVector.z).getNormalized() * deltaTime * 12.f;
-	PxVec3 left = PxVec3(-rightVector.x, 0, -rightVector.z).getNormalized() * deltaTime * 12.f;
+float PhysicsWorld::getFixedTimestep() {
+	return _fixedTimestep;
+}
 
-	
-	if (movement == PFORWARD) {
-		controllerPlayer->move(forward,0.02f,deltaTime,NULL);
-		
+
+void PhysicsWorld::queueMovement(Movement movement) {
+	_queuedMovement |= 1u << movement;
+}
+
+
+unsigned int PhysicsWorld::getQueuedMovement() {
+	return _queuedMovement;
+}
+
+
+unsigned int PhysicsWorld::step(float frameTime) {
+
+	PROFILE_SCOPE("physics step");
+
+	if (!_posesInitialized) {
+		// in case the level forgot to, walls added during setup have to exist before the first step
+		buildStaticColliders();
+		storeCurrentPoses();
+		_posesInitialized = true;
 	}
-	if (movement == PBACKWARD) {
-		controllerPlayer->move( backward, 0.02f, deltaTime, NULL);
+
+	// the reports are raised by fetchResults, so these are the ones of the steps finished during this call
+	gEvents.clearEvents();
+
+	// never owe more than maxSubsteps, a long frame slows the game down instead of making the next one even longer
+	float maxFrameTime = _fixedTimestep * _maxSubsteps;
+	_accumulator += frameTime < maxFrameTime ? frameTime : maxFrameTime;
+
+	// every step first collects the one that is still running, the last one is left running while the frame renders
+	unsigned int steps = 0;
+	while (_accumulator >= _fixedTimestep) {
+		finishSimulation();
+		beginStep();
+		_accumulator -= _fixedTimestep;
+		steps++;
 	}
-	if (movement == PLEFT) {
-		controllerPlayer->move(left, 0.02f, deltaTime, NULL);
+
+	// the input is kept until a step used it, a short key press during a frame without a step is not lost
+	if (steps > 0) {
+		_queuedMovement = 0;
 	}
-	if (movement == PRIGHT) {
-		controllerPlayer->move(right, 0.02f, deltaTime, NULL);
+
+	updateRenderPoses(_accumulator / _fixedTimestep);
+	return steps;
+}
+
+
+void PhysicsWorld::beginStep() {
+
+	PROFILE_SCOPE("begin step");
+	Timer gameplayTimer;
+	updatePlayer(makeMovementIntent(_queuedMovement), _fixedTimestep);
+	updatePerception();
+	updateEnemy();
+	updateEnemies(_fixedTimestep);
+
+	if (_diagnostics & PDIAG_COUNTERS) {
+		_stepCounters.gameplayMs = gameplayTimer.Duration() * 1000.0f;
+		Timer simulateTimer;
+		gScene->simulate(_fixedTimestep);
+		_stepCounters.simulateMs = simulateTimer.Duration() * 1000.0f;
+		_stepTimer.Reset();
 	}
-	if (movement == PJUMP && !airborne) {
-		velocity = 7.0f; // Set initial jump velocity
-		airborne = true;
-		JumpTimer.Reset();
+	else {
+		gScene->simulate(_fixedTimestep);
 	}
+	_simulating = true;
+}
 
-	// Apply gravity
-	if (gravityEnabled) {
-		controllerPlayer->move(PxVec3(0.f, velocity * deltaTime, 0.f), 0.02f, deltaTime, NULL);
-	}
 
-	// Check if the player is no longer airborne
-	if (controllerPlayer->getPosition().y <= 3.5) {
-		airborne = false;
-		gravityEnabled = true;
+void PhysicsWorld::finishSimulation() {
+
+	if (!_simulating)
+		return;
+
+	PROFILE_SCOPE("fetch results");
+
+	if (_diagnostics & PDIAG_COUNTERS) {
+		Timer fetchTimer;
+		gScene->fetchResults(true);
+		_stepCounters.fetchMs = fetchTimer.Duration() * 1000.0f;
+		_stepCounters.stepMs = _stepTimer.Duration() * 1000.0f;
+		storeStepCounters();
 	}
-	
-	PxExtendedVec3 position = controllerPlayer->getPosition();
+	else {
+		gScene->fetchResults(true);
+	}
+	_simulating = false;
 
-	glm::vec3 newPos = glm::vec3(position.x, position.y, position.z);
-	playerObject->UpdatePosition(newPos);
+	_playerPreviousPosition = _playerCurrentPosition;
+	_chaserPreviousPosition = _chaserCurrentPosition;
+	gPatrols.finishStep();
+	storeCurrentPoses();
 }
 
 
-void PhysicsWorld::updateEnemies(float deltaTime) {
+void PhysicsWorld::storeStepCounters() {
 
-	for (size_t i = 0; i < movingEnemies.size(); ++i) {
-		Enemy* currentEnemy = movingEnemies[i];
-		std::vector<physx::PxVec3>& path = currentEnemy->getControlPoints();
-		physx::PxRigidDynamic* actor = enemyDynamics[i];
+	PxSimulationStatistics statistics;
+	gScene->getSimulationStatistics(statistics);
 
-		//size_t currentPointIndex = currentEnemy->getControlPointIndex();
-		static size_t currentPointIndex = 0;
+	_stepCounters.activeDynamics = statistics.nbActiveDynamicBodies;
+	_stepCounters.activeKinematics = statistics.nbActiveKinematicBodies;
+	_stepCounters.pairs = statistics.nbDiscreteContactPairsTotal;
+	_stepCounters.touchingPairs = statistics.nbDiscreteContactPairsWithContacts;
+	_stepCounters.newTouches = statistics.nbNewTouches;
+	_stepCounters.lostTouches = statistics.nbLostTouches;
+	_stepCounters.constraints = statistics.nbActiveConstraints;
+}
 
-		// Calculate the direction to the next control point
-		physx::PxVec3 direction = path[currentPointIndex] - actor->getGlobalPose().p;
-		direction.normalize();
 
-		// Move the actor towards the next control point
-		physx::PxVec3 newPos = actor->getGlobalPose().p + direction * deltaTime;
-		// Calculate the rotation needed to face the direction
-		physx::PxVec3 forward = path[1] - path[0]; // initial forward direction
-		forward.normalize();
-		physx::PxQuat rotationQuat;
+void PhysicsWorld::storeCurrentPoses() {
 
-		if (direction.magnitude() > 0) {
-			physx::PxVec3 cross = forward.cross(direction);
-			float dot = forward.dot(direction);
-			float angle = acos(dot);
+	PxExtendedVec3 player = controllerPlayer->getPosition();
+	_playerCurrentPosition = PxVec3(static_cast<float>(player.x), static_cast<float>(player.y), static_cast<float>(player.z));
+	_chaserCurrentPosition = pTestEnemy->getGlobalPose().p;
 
-			rotationQuat = physx::PxQuat(angle, cross.getNormalized());
-		}
+	if (!_posesInitialized) {
+		_playerPreviousPosition = _playerCurrentPosition;
+		_chaserPreviousPosition = _chaserCurrentPosition;
+	}
+}
+
+
+void PhysicsWorld::updateRenderPoses(float alpha) {
 
-		// Set the new position and rotation
-		physx::PxTransform newTransform(newPos, rotationQuat);
-		actor->setKinematicTarget(newTransform);
-
-		// Update model position and rotation
-		Model* currentEnemy_model = (Model*)actor->userData;
-		currentEnemy_model->resetModelMatrix();
-		glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(newPos.x, newPos.y, newPos.z));
-		glm::quat glmQuat(rotationQuat.w, rotationQuat.x, rotationQuat.y, rotationQuat.z);
-		modelMatrix *= glm::mat4_cast(glmQuat);
-		currentEnemy_model->setModel(modelMatrix);
-
-		// Check if the actor has reached the current control point
-		float distanceToNextPoint = (path[currentPointIndex] - actor->getGlobalPose().p).magnitude();
-		if (distanceToNextPoint < 0.1f) {
-			// Move to the next control point
-			currentPointIndex = (currentPointIndex + 1) % path.size();
-			//currentEnemy->updateControlPointIndex();
+	PROFILE_SCOPE("render poses");
+
+	PxVec3 playerPos = _playerPreviousPosition + (_playerCurrentPosition - _playerPreviousPosition) * alpha;
+	Player* playerObject = (Player*)controllerPlayer->getUserData();
+	playerObject->UpdatePosition(glm::vec3(playerPos.x, playerPos.y, playerPos.z));
+
+	// the ball keeps looking at the player
+	PxVec3 chaserPos = _chaserPreviousPosition + (_chaserCurrentPosition - _chaserPreviousPosition) * alpha;
+	PxVec3 forward = (playerPos - chaserPos).getNormalized();
+	PxVec3 up(0.0f, 1.0f, 0.0f); // Assuming Y-up world
+	PxVec3 right = up.cross(forward).getNormalized();
+	up = forward.cross(right);
+
+	PxQuat rotationQuat(PxMat33(right, up, forward));
+	glm::quat glmQuat(rotationQuat.w, rotationQuat.x, rotationQuat.y, rotationQuat.z);
+
+	_renderPoses[_chaserBody] = glm::translate(glm::mat4(1.0f), glm::vec3(chaserPos.x, 3.0f, chaserPos.z)) * glm::toMat4(glmQuat);
+
+	// the patrols only ever move by their own targets, their poses are independent of each other
+	const std::vector<PxTransform>& previousPoses = gPatrols.getPreviousPoses();
+	const std::vector<PxTransform>& currentPoses = gPatrols.getCurrentPoses();
+	_pool->parallelFor(_patrolBodies.size(), [this, alpha, &previousPoses, &currentPoses](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const PxTransform& previous = previousPoses[i];
+			const PxTransform& current = currentPoses[i];
+
+			PxVec3 position = previous.p + (current.p - previous.p) * alpha;
+			glm::quat rotation = glm::slerp(
+				glm::quat(previous.q.w, previous.q.x, previous.q.y, previous.q.z),
+				glm::quat(current.q.w, current.q.x, current.q.y, current.q.z),
+				alpha);
+
+			_renderPoses[_patrolBodies[i]] = glm::translate(glm::mat4(1.0f), glm::vec3(position.x, position.y, position.z)) * glm::mat4_cast(rotation);
 		}
-	}
+	}, 64);
+}
+
+
+void PhysicsWorld::updatePlayer(const MovementIntent& intent, float deltaTime) {
+
+	Player* playerObject = (Player*)controllerPlayer->getUserData();
+	Camera* playerCamera = playerObject->getCamera();
+
+	// walking, jumping and gravity are a single sweep of the controller
+	_playerMotor.move(*controllerPlayer, intent, playerCamera->getFront(), playerCamera->getRight(), deltaTime);
+}
+
+
+void PhysicsWorld::updateEnemies(float deltaTime) {
+	PROFILE_SCOPE("patrols");
+	gPatrols.update(deltaTime, *_pool);
 }
 
 
@@ -349,36 +595,35 @@ glm::vec3 PhysicsWorld::getEnemyPosition() {
 
 
 boolean PhysicsWorld::isPlayerHit() {
-	
-	float distance = calcDirectionEnemyPlayer().magnitude();
-	if (distance < 2.5)
-	{
-		return true;
-	}
-	//TODO dont hardcode ballradius
-	for (size_t i = 0; i < movingEnemies.size(); ++i) {
-		Enemy* currentEnemy = movingEnemies[i];
-		physx::PxRigidDynamic* actor = enemyDynamics[i];
+	return gEvents.isPlayerHit();
+}
 
-		PxVec3 enemyPosition = actor->getGlobalPose().p;
-		distance = calcDirectionEnemyPlayer(enemyPosition).magnitude();
 
-		if (distance < 3.0)
-		{
-			return true;
-		}
-	}
+boolean PhysicsWorld::playerFoundKey() {
+	return gEvents.isKeyCollected();
+}
 
-	return false;
+
+const std::vector<GameplayEvent>& PhysicsWorld::getEvents() {
+	return gEvents.getEvents();
 }
 
 
-boolean PhysicsWorld::playerFoundKey() {
-	PxExtendedVec3 tmp = controllerPlayer->getPosition();
-	PxVec3 playerPos = PxVec3(tmp.x, tmp.y, tmp.z);
-	PxVec3 directionToPlayer = playerPos - keyPosition;
+boolean PhysicsWorld::isLineBlocked(glm::vec3 from, glm::vec3 to) {
 
-	return directionToPlayer.magnitude() < 2.0f;
+	PxVec3 origin = PxVec3(from.x, from.y, from.z);
+	PxVec3 direction = PxVec3(to.x, to.y, to.z) - origin;
+	float distance = direction.magnitude();
+	if (distance < 0.0001f)
+	{
+		return false;
+	}
+	direction /= distance;
+
+	// any static hit is enough, no need to find the closest one
+	PxRaycastBuffer hit;
+	PxQueryFilterData filterData(PxQueryFlag::eSTATIC | PxQueryFlag::eANY_HIT);
+	return gScene->raycast(origin, direction, distance, hit, PxHitFlag::eDEFAULT, filterData);
 }
 
 
@@ -413,35 +658,82 @@ PxVec3 PhysicsWorld::calcDirectionEnemyPlayer(PxVec3 position) {
 }
 
 
-void PhysicsWorld::updateEnemy() {
+void PhysicsWorld::updatePerception() {
 
-	PxVec3 directionToPlayer = calcDirectionEnemyPlayer();
+	PROFILE_SCOPE("perception");
+	gQueries.clear();
+	PxExtendedVec3 tmp = controllerPlayer->getPosition();
+	PxVec3 playerPos = PxVec3(static_cast<float>(tmp.x), static_cast<float>(tmp.y), static_cast<float>(tmp.z));
+
+	// walls are all that can hide the player, any of them is enough
+	PxQueryFlags sightFilter = PxQueryFlag::eSTATIC | PxQueryFlag::eANY_HIT;
+
+	PxVec3 toPlayer = playerPos - _chaserCurrentPosition;
+	float distance = toPlayer.magnitude();
+	_chaserSightQuery = gQueries.addRaycast(_chaserCurrentPosition, distance > 0.0f ? toPlayer / distance : PxVec3(0.0f), distance, sightFilter);
+
+	PxVec3 toTarget = _chaserTarget - _chaserCurrentPosition;
+	_chaserSweepQuery = gQueries.addSweep(_chaserCurrentPosition, _chaserRadius, toTarget.getNormalized(), CHASER_LOOKAHEAD, PxQueryFlag::eSTATIC);
+
+	const std::vector<PxTransform>& enemyPoses = gPatrols.getCurrentPoses();
+	enemySightQueries.resize(enemyPoses.size());
+	for (size_t i = 0; i < enemyPoses.size(); ++i) {
+		toPlayer = playerPos - enemyPoses[i].p;
+		distance = toPlayer.magnitude();
+		enemySightQueries[i] = distance < PATROL_SIGHT_RANGE && distance > 0.0f
+			? gQueries.addRaycast(enemyPoses[i].p, toPlayer / distance, distance, sightFilter)
+			: SIZE_MAX;
+	}
 
-	pTestEnemy->addForce(directionToPlayer / (directionToPlayer.magnitude() * (10)), PxForceMode::eIMPULSE);
-	PxVec3 position = pTestEnemy->getGlobalPose().p;
-	
-	glm::vec3 newPos = glm::vec3(position.x, 3.0f, position.z);
+	gQueries.execute(*gScene, *_pool);
+	const SceneQueryResults& results = gQueries.getResults();
 
-	directionToPlayer.normalize();
-	// Calculate the rotation needed to look at the player
-	PxVec3 forward = directionToPlayer;
-	PxVec3 up(0.0f, 1.0f, 0.0f); // Assuming Y-up world
-	PxVec3 right = up.cross(forward).getNormalized();
-	up = forward.cross(right);
+	_chaserSeesPlayer = !results.hit[_chaserSightQuery];
+	if (_chaserSeesPlayer) {
+		_chaserTarget = playerPos;
+	}
 
-	PxMat33 rotationMatrix(right, up, forward);
-	PxQuat rotationQuat(rotationMatrix);
+	enemySeesPlayer.resize(enemySightQueries.size());
+	for (size_t i = 0; i < enemySightQueries.size(); ++i) {
+		enemySeesPlayer[i] = enemySightQueries[i] != SIZE_MAX && !results.hit[enemySightQueries[i]];
+	}
+}
 
-	// Get the enemy model
-	Model* enemy = (Model*)pTestEnemy->userData;
-	enemy->resetModelMatrix();
 
-	// Convert PxQuat to glm::quat
-	glm::quat glmQuat(rotationQuat.w, rotationQuat.x, rotationQuat.y, rotationQuat.z);
+boolean PhysicsWorld::canChaserSeePlayer() {
+	return _chaserSeesPlayer;
+}
+
 
-	// Create the model matrix with the new position and rotation
-	glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), newPos) * glm::toMat4(glmQuat);
-	enemy->setModel(modelMatrix);
+boolean PhysicsWorld::canEnemySeePlayer(size_t index) {
+	return index < enemySeesPlayer.size() && enemySeesPlayer[index];
+}
+
+
+void PhysicsWorld::updateEnemy() {
+
+	PROFILE_SCOPE("chaser");
+	PxVec3 direction = _chaserTarget - _chaserCurrentPosition;
+	float distance = direction.magnitude();
+	if (distance < 0.0001f)
+	{
+		return;
+	}
+	direction /= distance;
+
+	// slide along the wall in the way instead of pushing into it
+	const SceneQueryResults& results = gQueries.getResults();
+	if (results.hit[_chaserSweepQuery]) {
+		PxVec3 normal = results.normal[_chaserSweepQuery];
+		direction -= normal * direction.dot(normal);
+		if (direction.magnitude() < 0.0001f)
+		{
+			return;
+		}
+		direction.normalize();
+	}
+
+	pTestEnemy->addForce(direction / 10, PxForceMode::eIMPULSE);
 }
 
 
@@ -459,8 +751,19 @@ void PhysicsWorld::draw() {
 
 void PhysicsWorld::resetGame() {
 
+	finishSimulation();
 	controllerPlayer->setPosition(PxExtendedVec3(0.0f, 3.5f, 0.0f));
-	
+
+	// teleport, do not interpolate from where the player died
+	_playerCurrentPosition = PxVec3(0.0f, 3.5f, 0.0f);
+	_playerPreviousPosition = _playerCurrentPosition;
+	_playerMotor.reset();
+
+	// the reports of the teleport arrive with the next step, until then nothing touches the player
+	gEvents.reset();
+
+	// the ball has to find the player again
+	_chaserTarget = _chaserCurrentPosition;
 }
 
 
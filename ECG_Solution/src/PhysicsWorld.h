@@ -10,38 +10,48 @@
 #include "Geometry.h"
 #include "OwnUtils.h"
 #include "Player.h"
+#include "ThreadPool.h"
+#include "StaticColliderBuilder.h"
+#include "CollisionMeshCache.h"
+#include "GameplayEvents.h"
+#include "PhysicsDiagnostics.h"
+#include "SceneQueryBatch.h"
+#include "PatrolEnemies.h"
+#include "Timer.h"
+#include "CharacterMotor.h"
 using namespace physx;
 
-//Abstraction of player movement 
-enum Movement {
-
-	PFORWARD,
-	PBACKWARD,
-	PLEFT,
-	PRIGHT,
-	PJUMP,
-	PNOMOVEMENT,
-	PSPRINT
-};
-
 class PhysicsWorld
 {
 private:
 
 	//necessary init variables for PhysX Foundation
-	PxDefaultAllocator		gAllocator;
+	TrackedPhysXAllocator	gAllocator;
 	PxDefaultErrorCallback	gErrorCallback;
 
 	PxFoundation* gFoundation = nullptr;
 	PxPhysics* gPhysics = nullptr;
 
-	PxDefaultCpuDispatcher* gDispatcher = nullptr;
+	PxCpuDispatcher* gDispatcher = nullptr;
 	PxScene* gScene = nullptr;
 
 	PxMaterial* gMaterial = nullptr;
+
+	//diagnostics, all of it stays unused unless asked for
+	unsigned int _diagnostics = PDIAG_NONE;
 	PxPvd* gPvd = nullptr;
+	PxPvdTransport* gTransport = nullptr;
+	PhysicsProfiler* gProfiler = nullptr;
+	PxProfilerCallback* gPreviousProfiler = nullptr;
+	PhysicsStepCounters _stepCounters;
+	Timer _stepTimer;
 
+	ThreadPool* _pool = nullptr;
 	PxControllerManager* gManager = nullptr;
+	StaticColliderBuilder* gStaticColliders = nullptr;
+	CollisionMeshCache* gCollisionMeshes = nullptr;
+	GameplayEventCallback gEvents;
+	PxRigidStatic* pKeyTrigger = nullptr;
 	PxController* controllerPlayer = nullptr;
 
 	std::vector<Geometry*> gObjects;
@@ -53,9 +63,27 @@ private:
 	PxRigidDynamic* pPlayer;
 	PxRigidDynamic* pTestEnemy;
 
-	// these vectors are for storing an Enemy and the corresponding rigidbody dynamics
-	std::vector<Enemy*> movingEnemies;
-	std::vector<PxRigidDynamic*> enemyDynamics;
+	//enemies that walk along their paths
+	PatrolEnemies gPatrols;
+
+	//interpolated poses of the moving bodies, the scene copies them into its transforms
+	std::vector<glm::mat4> _renderPoses;
+	size_t _chaserBody = 0;
+	//body of every patrol, in the order of gPatrols
+	std::vector<size_t> _patrolBodies;
+
+	//line of sight and movement checks of all enemies, run together once per step
+	SceneQueryBatch gQueries;
+	size_t _chaserSightQuery = 0;
+	size_t _chaserSweepQuery = 0;
+	//SIZE_MAX for enemies that are too far away to see the player
+	std::vector<size_t> enemySightQueries;
+	std::vector<uint8_t> enemySeesPlayer;
+
+	//the ball goes where it saw the player last, it does not know about players behind walls
+	float _chaserRadius = 1.0f;
+	bool _chaserSeesPlayer = false;
+	PxVec3 _chaserTarget = PxVec3(0.0f);
 
 	//variables for keeping track
 	float _downForce = -10.f;
@@ -64,12 +92,59 @@ private:
 	int _scoreCounter = 0;
 	boolean foundKey = false;
 	PxVec3 keyPosition = PxVec3(0.0f, 0.0f, 0.0f);
+
+	//fixed rate simulation clock, frames hand in their time and the scene is stepped in equal pieces
+	float _fixedTimestep = 1.0f / 60.0f;
+	unsigned int _maxSubsteps = 5;
+	float _accumulator = 0.0f;
+	//one bit per Movement, collected during the frame and consumed by the next fixed steps
+	unsigned int _queuedMovement = 0;
+	CharacterMotor _playerMotor;
+
+	//the last step of a frame is simulated while the frame renders and fetched when the next step starts
+	bool _simulating = false;
+
+	//poses after the last two finished steps, the render poses are interpolated between them
+	bool _posesInitialized = false;
+	PxVec3 _playerPreviousPosition, _playerCurrentPosition;
+	PxVec3 _chaserPreviousPosition, _chaserCurrentPosition;
+
+	//moves player and enemies with the queued input and starts simulating one fixed timestep, does not wait for it
+	void beginStep();
+	void storeCurrentPoses();
+	//copies the statistics of the step that was just fetched
+	void storeStepCounters();
+	//casts the sight rays and movement sweeps of all enemies and reads their results
+	void updatePerception();
+
+	//a static actor with a cooked mesh, the scale of the model matrix goes into the geometry
+	bool addStaticMesh(PxBase* mesh, glm::mat4 modelMatrix, void* userData);
+
+	//adds a sphere that reports when the player enters or leaves it, it does not collide
+	void attachTrigger(PxRigidActor& actor, float radius, PhysicsFilterGroup group);
+	//moves the camera and the render poses of the enemies to the poses alpha of the way from the previous to the current step
+	void updateRenderPoses(float alpha);
 	
 public:
 	PhysicsWorld();
 	
-	//initializes PhysX context
-	void initPhysics();
+	//initializes PhysX context, the simulation runs its tasks on the given pool
+	//diagnostics is a combination of PhysicsDiagnosticsFlag, the PVD can only be chosen here
+	void initPhysics(ThreadPool& pool, unsigned int diagnostics = PDIAG_NONE, const std::string& pvdFile = "physx_capture.pxd2");
+
+	//switches the profiler and the counters on or off, the PVD flags are ignored after initPhysics
+	void setDiagnostics(unsigned int diagnostics);
+
+	unsigned int getDiagnostics();
+
+	//counters of the last finished step, only filled with PDIAG_COUNTERS
+	const PhysicsStepCounters& getStepCounters();
+
+	//null unless PDIAG_PROFILER is set
+	PhysicsProfiler* getProfiler();
+
+	//closes the PVD connection so a capture file is complete and prints the profile zones, call once at shutdown
+	void closeDiagnostics();
 
 	//returns the simulation scene
 	PxScene* getScene();
@@ -77,27 +152,69 @@ public:
 	// sets the positon for the key in the Physics World
 	void setKeyPosition(PxVec3 position);
 
-	//add a Cube Geometry object into the simulation as a rigidbody
+	//creates the actors of all static cubes added so far, identical boxes share their shape
+	void buildStaticColliders();
+
+	//add a Cube Geometry object into the simulation as a rigidbody, static ones only exist after buildStaticColliders
 	void addCubeToPWorld(Geometry& obj, glm::vec3 measurements, bool isStatic = true,bool isTorchHitbox = false);
 	
 	void addCubeToPWorld(Model& obj, glm::vec3 measurements, bool isStatic = true, bool isTorchHitbox = false);
 
+	//add a static Model with a collider cooked from its triangles, convex hull or exact triangle mesh
+	//returns false if no collider could be made, the caller should fall back to a box then
+	bool addMeshToPWorld(Model& obj, CollisionMeshType type);
+
+	//the same for a mesh an earlier run cooked, by the source hash of its model, without the model itself
+	//returns false if the mesh is not in the collision cache
+	bool addCachedMeshToPWorld(uint64_t sourceHash, glm::mat4 transform);
+
 	void addPlayerToPWorld(Player& player, glm::vec3 measurements);
 
 	//add a Sphere Geometry object into the simulation as a rigidbody
 	void addSphereToPWorld(Geometry& obj, float radius, bool isStatic = true);
 
-	void addSphereToPWorld(Model& obj, float radius, bool isStatic);
+	//the same without anything to draw, the level and headless runs build the world with these
+	//a static box, only exists after buildStaticColliders
+	void addStaticBox(glm::mat4 transform, glm::vec3 halfExtents);
+
+	//the ball that chases the player
+	void addChaser(glm::vec3 position, float radius);
+
+	//returns the index of the enemy
+	size_t addPatrolEnemy(glm::vec3 position, float radius, const std::vector<PxVec3>& path);
+
+	//the bodies are indices into the render poses
+	size_t getChaserBody();
+	size_t getPatrolBody(size_t index);
+
+	//poses of all moving bodies between the last two steps, updated by step
+	const std::vector<glm::mat4>& getRenderPoses();
+
+	//sets the rate the scene is stepped with and how many steps a single frame may take at most
+	void setFixedTimestep(float timestep, unsigned int maxSubsteps);
 
-	void addEnemyToPWorld(Model& obj, Enemy& enem, float radius);
+	float getFixedTimestep();
 
-	//updates the Player in the rendered World
-	void updatePlayer(Movement movement, float deltaTime);
+	//remembers a movement for the next fixed step, held keys are queued again every frame
+	void queueMovement(Movement movement);
 
-	// updates the patroling enemies
+	//one bit per Movement that was queued since the last step
+	unsigned int getQueuedMovement();
+
+	//advances the simulation by frameTime in fixed steps and interpolates the rendered poses, returns the number of steps taken
+	//the last step keeps running in the background, rendering uses the poses of the two steps before it
+	unsigned int step(float frameTime);
+
+	//waits for the step that is still simulating, needed before anything writes to the scene outside of step
+	void finishSimulation();
+
+	//moves the player controller, called once per fixed step with all movement queued for it
+	void updatePlayer(const MovementIntent& intent, float deltaTime);
+
+	// moves all patroling enemies one step along their paths
 	void updateEnemies(float deltaTime);
 
-	// updates the single brain enemy
+	// updates the single brain enemy, it chases what it perceived in this step
 	void updateEnemy();
 
 	//boolean wether the player is dead or alive 
@@ -105,12 +222,22 @@ public:
 
 	glm::vec3 getEnemyPosition();
 
-	//checks if player collides with the ball
+	//checks if player touches the ball or one of the patroling enemies, answered from the trigger reports
 	boolean isPlayerHit();
 
 	// checks if the player found the key and got close enough to win
 	boolean playerFoundKey();
 
+	//gameplay events raised by the steps finished during the last call to step
+	const std::vector<GameplayEvent>& getEvents();
+
+	//checks if static geometry (walls, floor) lies between the two points
+	boolean isLineBlocked(glm::vec3 from, glm::vec3 to);
+
+	//results of the perception queries of the last step
+	boolean canChaserSeePlayer();
+	boolean canEnemySeePlayer(size_t index);
+
 	//calculates the vector from ball to player
 	PxVec3 calcDirectionEnemyPlayer();
 
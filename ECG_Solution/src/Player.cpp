@@ -63,6 +63,10 @@
 		float yaw = _camera->getYaw();
 		float pitch = _camera->getPitch();
 
+		// headless runs have neither light nor hand
+		if (!_player_light || !_skeleton_arm)
+			return;
+
 		glm::vec3 position = _camera->getPosition();
 
 		_player_light->position = (position);
@@ -15,9 +15,9 @@ class Player
 private:
 	Camera* _camera;
 	
-	Model* _skeleton_arm;
+	Model* _skeleton_arm = nullptr;
 
-	PointLight* _player_light;
+	PointLight* _player_light = nullptr;
 
 public:
 
@@ -0,0 +1,85 @@
+#include "Registry.h"
+
+
+Entity Registry::create()
+{
+	Entity entity;
+	if (!_freeEntities.empty()) {
+		entity = _freeEntities.back();
+		_freeEntities.pop_back();
+	}
+	else {
+		entity = static_cast<Entity>(_alive.size());
+		_alive.push_back(0);
+	}
+	_alive[entity] = 1;
+	return entity;
+}
+
+void Registry::destroy(Entity entity)
+{
+	if (!isAlive(entity))
+		return;
+
+	// the transforms keep every parent in front of its children
+	_transforms.removeOrdered(entity);
+	_renders.remove(entity);
+	_physics.remove(entity);
+	_paths.remove(entity);
+	_lights.remove(entity);
+	_emitters.remove(entity);
+	_alive[entity] = 0;
+	_freeEntities.push_back(entity);
+}
+
+bool Registry::isAlive(Entity entity) const
+{
+	return entity < _alive.size() && _alive[entity] != 0;
+}
+
+void Registry::clear()
+{
+	_transforms.clear();
+	_renders.clear();
+	_physics.clear();
+	_paths.clear();
+	_lights.clear();
+	_emitters.clear();
+	_freeEntities.clear();
+	_alive.clear();
+}
+
+size_t Registry::getEntityCount() const
+{
+	return _alive.size() - _freeEntities.size();
+}
+
+ComponentPool<TransformComponent>& Registry::getTransforms()
+{
+	return _transforms;
+}
+
+ComponentPool<RenderComponent>& Registry::getRenders()
+{
+	return _renders;
+}
+
+ComponentPool<PhysicsComponent>& Registry::getPhysics()
+{
+	return _physics;
+}
+
+ComponentPool<PathComponent>& Registry::getPaths()
+{
+	return _paths;
+}
+
+ComponentPool<LightComponent>& Registry::getLights()
+{
+	return _lights;
+}
+
+ComponentPool<EmitterComponent>& Registry::getEmitters()
+{
+	return _emitters;
+}
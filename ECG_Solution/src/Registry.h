@@ -0,0 +1,190 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "Components.h"
+
+
+/*
+The components of one type, packed without gaps.
+A sparse array maps the entity to its slot in the dense arrays, so lookups are a
+single index and systems walk the components and their entities front to back.
+Removing moves the last component into the hole, the order of the dense arrays is
+not stable unless it is removed with removeOrdered.
+*/
+template <typename T>
+class ComponentPool
+{
+private:
+	//slot of every entity in the dense arrays, NO_ENTITY if it has no component
+	std::vector<uint32_t> _sparse;
+	std::vector<Entity> _entities;
+	std::vector<T> _components;
+
+public:
+	//replaces the component if the entity has one already
+	T& add(Entity entity, const T& component)
+	{
+		if (entity >= _sparse.size())
+			_sparse.resize(entity + 1, NO_ENTITY);
+
+		uint32_t slot = _sparse[entity];
+		if (slot != NO_ENTITY) {
+			_components[slot] = component;
+			return _components[slot];
+		}
+
+		_sparse[entity] = static_cast<uint32_t>(_components.size());
+		_entities.push_back(entity);
+		_components.push_back(component);
+		return _components.back();
+	}
+
+	void remove(Entity entity)
+	{
+		if (!has(entity))
+			return;
+
+		uint32_t slot = _sparse[entity];
+		uint32_t last = static_cast<uint32_t>(_components.size() - 1);
+		if (slot != last) {
+			_components[slot] = _components[last];
+			_entities[slot] = _entities[last];
+			_sparse[_entities[slot]] = slot;
+		}
+		_components.pop_back();
+		_entities.pop_back();
+		_sparse[entity] = NO_ENTITY;
+	}
+
+	//keeps the order of the other components, moves every component after it
+	void removeOrdered(Entity entity)
+	{
+		if (!has(entity))
+			return;
+
+		uint32_t slot = _sparse[entity];
+		_components.erase(_components.begin() + slot);
+		_entities.erase(_entities.begin() + slot);
+		for (size_t i = slot; i < _entities.size(); i++) {
+			_sparse[_entities[i]] = static_cast<uint32_t>(i);
+		}
+		_sparse[entity] = NO_ENTITY;
+	}
+
+	//reorders the dense arrays, less compares two entities, equal ones keep their order
+	template <typename Less>
+	void sort(Less less)
+	{
+		std::vector<uint32_t> order(_entities.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = static_cast<uint32_t>(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [this, &less](uint32_t a, uint32_t b) {
+			return less(_entities[a], _entities[b]);
+		});
+
+		std::vector<Entity> entities;
+		std::vector<T> components;
+		entities.reserve(order.size());
+		components.reserve(order.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			entities.push_back(_entities[order[i]]);
+			components.push_back(_components[order[i]]);
+			_sparse[entities.back()] = static_cast<uint32_t>(i);
+		}
+		_entities.swap(entities);
+		_components.swap(components);
+	}
+
+	bool has(Entity entity) const
+	{
+		return entity < _sparse.size() && _sparse[entity] != NO_ENTITY;
+	}
+
+	//null if the entity has no such component, the pointer is invalidated by add, remove and sort
+	T* get(Entity entity)
+	{
+		return has(entity) ? &_components[_sparse[entity]] : nullptr;
+	}
+
+	//slot of the component in the dense arrays, NO_ENTITY if the entity has none
+	uint32_t getSlot(Entity entity) const
+	{
+		return has(entity) ? _sparse[entity] : NO_ENTITY;
+	}
+
+	void clear()
+	{
+		_sparse.clear();
+		_entities.clear();
+		_components.clear();
+	}
+
+	void reserve(size_t count)
+	{
+		_entities.reserve(count);
+		_components.reserve(count);
+	}
+
+	size_t size() const
+	{
+		return _components.size();
+	}
+
+	//the dense arrays, the entity at index i owns the component at index i
+	const std::vector<Entity>& getEntities() const
+	{
+		return _entities;
+	}
+
+	std::vector<T>& getComponents()
+	{
+		return _components;
+	}
+
+	const std::vector<T>& getComponents() const
+	{
+		return _components;
+	}
+};
+
+/*
+All entities of the scene and one pool per component type.
+An entity is only an id, everything about it lives in the pools. Ids of destroyed
+entities are handed out again, so nothing may keep an id after destroying it.
+*/
+class Registry
+{
+private:
+	std::vector<Entity> _freeEntities;
+	//1 for every id that is in use
+	std::vector<uint8_t> _alive;
+
+	ComponentPool<TransformComponent> _transforms;
+	ComponentPool<RenderComponent> _renders;
+	ComponentPool<PhysicsComponent> _physics;
+	ComponentPool<PathComponent> _paths;
+	ComponentPool<LightComponent> _lights;
+	ComponentPool<EmitterComponent> _emitters;
+
+public:
+	Entity create();
+
+	//removes every component of the entity and frees its id
+	void destroy(Entity entity);
+
+	bool isAlive(Entity entity) const;
+
+	//destroys all entities
+	void clear();
+
+	size_t getEntityCount() const;
+
+	ComponentPool<TransformComponent>& getTransforms();
+	ComponentPool<RenderComponent>& getRenders();
+	ComponentPool<PhysicsComponent>& getPhysics();
+	ComponentPool<PathComponent>& getPaths();
+	ComponentPool<LightComponent>& getLights();
+	ComponentPool<EmitterComponent>& getEmitters();
+};
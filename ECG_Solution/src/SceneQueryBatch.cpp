@@ -0,0 +1,97 @@
+#include "SceneQueryBatch.h"
+
+using namespace physx;
+
+
+//queries per task, a single raycast is too little work to hand to another thread
+static const size_t QUERY_GRAIN = 16;
+
+
+size_t SceneQueryBatch::add(const PxVec3& origin, const PxVec3& unitDirection, float distance, float radius, PxQueryFlags filter)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_origins.push_back(origin);
+	_directions.push_back(unitDirection);
+	_distances.push_back(distance);
+	_radii.push_back(radius);
+	_filters.push_back(filter);
+	return _origins.size() - 1;
+}
+
+size_t SceneQueryBatch::addRaycast(const PxVec3& origin, const PxVec3& unitDirection, float distance, PxQueryFlags filter)
+{
+	return add(origin, unitDirection, distance, 0.0f, filter);
+}
+
+size_t SceneQueryBatch::addSweep(const PxVec3& origin, float radius, const PxVec3& unitDirection, float distance, PxQueryFlags filter)
+{
+	return add(origin, unitDirection, distance, radius, filter);
+}
+
+void SceneQueryBatch::execute(PxScene& scene, ThreadPool& pool)
+{
+	size_t count = _origins.size();
+	_results.hit.assign(count, 0);
+	_results.distance.assign(count, 0.0f);
+	_results.position.assign(count, PxVec3(0.0f));
+	_results.normal.assign(count, PxVec3(0.0f));
+	_results.actor.assign(count, nullptr);
+
+	pool.parallelFor(count, [this, &scene](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			// a query without a direction can not hit anything
+			if (_distances[i] <= 0.0f || _directions[i].isZero())
+				continue;
+
+			PxQueryFilterData filterData(_filters[i]);
+			PxLocationHit* hit = nullptr;
+			PxRaycastBuffer rayHit;
+			PxSweepBuffer sweepHit;
+
+			if (_radii[i] > 0.0f) {
+				// MTD gives a usable normal when the sphere already touches something at the start
+				if (scene.sweep(PxSphereGeometry(_radii[i]), PxTransform(_origins[i]), _directions[i], _distances[i], sweepHit, PxHitFlag::eDEFAULT | PxHitFlag::eMTD, filterData))
+					hit = &sweepHit.block;
+			}
+			else {
+				if (scene.raycast(_origins[i], _directions[i], _distances[i], rayHit, PxHitFlag::eDEFAULT, filterData))
+					hit = &rayHit.block;
+			}
+
+			if (!hit)
+				continue;
+
+			_results.hit[i] = 1;
+			_results.distance[i] = hit->distance;
+			_results.position[i] = hit->position;
+			_results.normal[i] = hit->normal;
+			_results.actor[i] = hit->actor;
+		}
+	}, QUERY_GRAIN);
+}
+
+const SceneQueryResults& SceneQueryBatch::getResults() const
+{
+	return _results;
+}
+
+size_t SceneQueryBatch::size()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _origins.size();
+}
+
+void SceneQueryBatch::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_origins.clear();
+	_directions.clear();
+	_distances.clear();
+	_radii.clear();
+	_filters.clear();
+	_results.hit.clear();
+	_results.distance.clear();
+	_results.position.clear();
+	_results.normal.clear();
+	_results.actor.clear();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "PxPhysicsAPI.h"
+#include "ThreadPool.h"
+
+
+//results of one executed batch, entry i belongs to the query that add returned i for
+struct SceneQueryResults {
+
+	std::vector<uint8_t> hit;
+	std::vector<float> distance;
+	std::vector<physx::PxVec3> position;
+	std::vector<physx::PxVec3> normal;
+	std::vector<physx::PxRigidActor*> actor;
+
+	size_t size() const { return hit.size(); }
+};
+
+/*
+Collects raycasts and sphere sweeps from all AI agents and runs them in one go,
+spread over the thread pool. Requests and results are kept as structure of arrays.
+Queries can be added from any thread; execute must not overlap with anything that
+writes to the scene, so it belongs between fetchResults and the next simulate.
+*/
+class SceneQueryBatch
+{
+private:
+	std::mutex _mutex;
+
+	std::vector<physx::PxVec3> _origins;
+	std::vector<physx::PxVec3> _directions;
+	std::vector<float> _distances;
+	//0 for raycasts
+	std::vector<float> _radii;
+	std::vector<physx::PxQueryFlags> _filters;
+
+	SceneQueryResults _results;
+
+	size_t add(const physx::PxVec3& origin, const physx::PxVec3& unitDirection, float distance, float radius, physx::PxQueryFlags filter);
+
+public:
+	//filter decides which actors count, add eANY_HIT if only "is something in between" matters
+	size_t addRaycast(const physx::PxVec3& origin, const physx::PxVec3& unitDirection, float distance,
+		physx::PxQueryFlags filter = physx::PxQueryFlag::eSTATIC | physx::PxQueryFlag::eDYNAMIC);
+
+	//moves a sphere of radius from origin along the direction
+	size_t addSweep(const physx::PxVec3& origin, float radius, const physx::PxVec3& unitDirection, float distance,
+		physx::PxQueryFlags filter = physx::PxQueryFlag::eSTATIC | physx::PxQueryFlag::eDYNAMIC);
+
+	//runs every query added since the last clear, blocks until all are done
+	void execute(physx::PxScene& scene, ThreadPool& pool);
+
+	const SceneQueryResults& getResults() const;
+
+	size_t size();
+
+	//forgets the queries and their results, the memory is kept for the next batch
+	void clear();
+};
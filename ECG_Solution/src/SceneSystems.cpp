@@ -0,0 +1,88 @@
+#include "SceneSystems.h"
+#include <algorithm>
+#include "PhysicsWorld.h"
+#include "Model.h"
+#include "Geometry.h"
+#include "Shader.h"
+#include "FrameProfiler.h"
+
+
+void syncPhysicsTransforms(Registry& scene, PhysicsWorld& world)
+{
+	PROFILE_SCOPE("sync transforms");
+
+	const std::vector<glm::mat4>& poses = world.getRenderPoses();
+	ComponentPool<PhysicsComponent>& physics = scene.getPhysics();
+	ComponentPool<TransformComponent>& transforms = scene.getTransforms();
+
+	const std::vector<PhysicsComponent>& bodies = physics.getComponents();
+	const std::vector<Entity>& entities = physics.getEntities();
+	for (size_t i = 0; i < bodies.size(); i++) {
+		TransformComponent* transform = transforms.get(entities[i]);
+		if (transform) {
+			transform->local = poses[bodies[i].body];
+			transform->dirty = true;
+		}
+	}
+}
+
+void buildDrawList(Registry& scene, DrawList& list)
+{
+	PROFILE_SCOPE("draw list");
+
+	for (int pass = 0; pass < PRENDER_PASS_COUNT; pass++) {
+		list.passes[pass].clear();
+	}
+
+	ComponentPool<RenderComponent>& renders = scene.getRenders();
+	ComponentPool<TransformComponent>& transforms = scene.getTransforms();
+
+	const std::vector<RenderComponent>& components = renders.getComponents();
+	const std::vector<Entity>& entities = renders.getEntities();
+	for (size_t i = 0; i < components.size(); i++) {
+		const TransformComponent* transform = transforms.get(entities[i]);
+		if (!transform)
+			continue;
+
+		const RenderComponent& render = components[i];
+		DrawItem item;
+		item.model = render.model;
+		item.geometry = render.geometry;
+		item.world = transform->world;
+		item.normal = transform->normal;
+		list.passes[render.pass].push_back(item);
+	}
+
+	// the order of the pools changes with every removal, the sort keeps the models together anyway
+	for (int pass = 0; pass < PRENDER_PASS_COUNT; pass++) {
+		std::sort(list.passes[pass].begin(), list.passes[pass].end(), [](const DrawItem& a, const DrawItem& b) {
+			if (a.model != b.model)
+				return a.model < b.model;
+			return a.geometry < b.geometry;
+		});
+	}
+}
+
+void drawRenderPass(const DrawList& list, RenderPass pass, Shader* shader)
+{
+	const std::vector<DrawItem>& items = list.passes[pass];
+	for (size_t i = 0; i < items.size(); i++) {
+		const DrawItem& item = items[i];
+
+		switch (pass) {
+		case PRENDER_GEOMETRY:
+			item.geometry->draw(item.world, item.normal);
+			break;
+		case PRENDER_LIT:
+			item.model->Draw(item.world, item.normal);
+			break;
+		case PRENDER_NORMAL_MAPPED:
+			shader->setUniform("model", item.world);
+			shader->setUniform("normalMatrix", item.normal);
+			item.model->Draw(*shader);
+			break;
+		default:
+			break;
+		}
+	}
+}
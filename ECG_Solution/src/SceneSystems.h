@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "Registry.h"
+
+class PhysicsWorld;
+class Shader;
+
+
+struct DrawItem {
+
+	Model* model;
+	Geometry* geometry;
+	glm::mat4 world;
+	glm::mat3 normal;
+};
+
+//the draws of one frame, one list per pass, sorted so equal models are drawn one after another
+struct DrawList {
+
+	std::vector<DrawItem> passes[PRENDER_PASS_COUNT];
+};
+
+//copies the interpolated pose of every physics body into the transform of its entity, run updateTransforms after it
+void syncPhysicsTransforms(Registry& scene, PhysicsWorld& world);
+
+//collects every entity with a render component and a transform, the lists keep their memory from frame to frame
+//the transforms have to be updated already
+void buildDrawList(Registry& scene, DrawList& list);
+
+//the shader is only needed for the normal mapped pass, the others draw with their own
+void drawRenderPass(const DrawList& list, RenderPass pass, Shader* shader = nullptr);
@@ -0,0 +1,110 @@
+#include "SessionRecording.h"
+#include <cstring>
+
+
+static const char RECORDING_MAGIC[4] = { 'G', 'O', 'R', 'C' };
+static const uint32_t RECORDING_VERSION = 2;
+
+//where the frame count sits in the header, rewritten when the recording is closed
+static const std::streamoff FRAME_COUNT_OFFSET = sizeof(RECORDING_MAGIC) + sizeof(uint32_t) * 3 + sizeof(uint64_t);
+
+
+//fields are written one by one, so the layout does not depend on struct padding
+template<typename T>
+static void writeValue(std::ostream& stream, const T& value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool readValue(std::istream& stream, T& value)
+{
+	return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+
+SessionRecorder::~SessionRecorder()
+{
+	close();
+}
+
+bool SessionRecorder::open(const std::string& path, const RecordingHeader& header)
+{
+	_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!_file)
+		return false;
+
+	_header = header;
+	_header.frameCount = 0;
+
+	_file.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	writeValue(_file, RECORDING_VERSION);
+	writeValue(_file, _header.physicsRate);
+	writeValue(_file, _header.maxSubsteps);
+	writeValue(_file, _header.pondRimSource);
+	writeValue(_file, _header.frameCount);
+	return static_cast<bool>(_file);
+}
+
+bool SessionRecorder::isOpen()
+{
+	return _file.is_open();
+}
+
+void SessionRecorder::addFlags(uint8_t flags)
+{
+	_pendingFlags |= flags;
+}
+
+void SessionRecorder::record(RecordedFrame frame)
+{
+	if (!_file.is_open())
+		return;
+
+	frame.flags |= _pendingFlags;
+	_pendingFlags = 0;
+
+	writeValue(_file, frame.deltaTime);
+	writeValue(_file, frame.mouseX);
+	writeValue(_file, frame.mouseY);
+	writeValue(_file, frame.movement);
+	writeValue(_file, frame.flags);
+	_header.frameCount++;
+}
+
+void SessionRecorder::close()
+{
+	if (!_file.is_open())
+		return;
+
+	_file.seekp(FRAME_COUNT_OFFSET);
+	writeValue(_file, _header.frameCount);
+	_file.close();
+}
+
+
+bool loadRecording(const std::string& path, RecordingHeader& header, std::vector<RecordedFrame>& frames)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	char magic[sizeof(RECORDING_MAGIC)];
+	uint32_t version = 0;
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0)
+		return false;
+	if (!readValue(file, version) || version != RECORDING_VERSION)
+		return false;
+	if (!readValue(file, header.physicsRate) || !readValue(file, header.maxSubsteps) || !readValue(file, header.pondRimSource) || !readValue(file, header.frameCount))
+		return false;
+
+	// a recording that was not closed has no frame count, it is read until the end then
+	frames.clear();
+	frames.reserve(header.frameCount);
+	RecordedFrame frame;
+	while (readValue(file, frame.deltaTime) && readValue(file, frame.mouseX) && readValue(file, frame.mouseY)
+		&& readValue(file, frame.movement) && readValue(file, frame.flags)) {
+		frames.push_back(frame);
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+
+enum RecordedFrameFlag {
+
+	//the game was restarted before this frame was simulated
+	PRECORD_RESET = 1 << 0
+};
+
+//everything the simulation took from the outside during one frame
+struct RecordedFrame {
+
+	float deltaTime = 0.0f;
+	//mouse movement of the frame, applied to the player once
+	float mouseX = 0.0f;
+	float mouseY = 0.0f;
+	//one bit per Movement
+	uint8_t movement = 0;
+	uint8_t flags = 0;
+};
+
+//settings that change the outcome of a session, a replay uses the recorded ones
+struct RecordingHeader {
+
+	float physicsRate = 60.0f;
+	uint32_t maxSubsteps = 5;
+	//source hash of the cooked pond rim in the collision cache, 0 if the rim was its box
+	uint64_t pondRimSource = 0;
+	uint32_t frameCount = 0;
+};
+
+/*
+Writes the input and timestep of every frame to a compact binary log,
+14 bytes per frame after a small header. Frames are streamed to the file,
+the frame count in the header is filled in by close.
+*/
+class SessionRecorder
+{
+private:
+	std::ofstream _file;
+	RecordingHeader _header;
+	uint8_t _pendingFlags = 0;
+
+public:
+	~SessionRecorder();
+
+	bool open(const std::string& path, const RecordingHeader& header);
+	bool isOpen();
+
+	//attached to the next recorded frame
+	void addFlags(uint8_t flags);
+
+	void record(RecordedFrame frame);
+
+	void close();
+};
+
+//reads a log written by SessionRecorder, returns false if it is missing or not a recording
+bool loadRecording(const std::string& path, RecordingHeader& header, std::vector<RecordedFrame>& frames);
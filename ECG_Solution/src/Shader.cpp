@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "GpuMemory.h"
 
 GLint Shader::getUni(std::string uni) {
 
@@ -65,6 +66,7 @@ int Shader::initFreeType(std::map<GLchar, Character>& _characters, string font_n
 				GL_UNSIGNED_BYTE,
 				face->glyph->bitmap.buffer
 			);
+			gpuTrackTexture(PMEM_UI, texture);
 			// set texture options
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
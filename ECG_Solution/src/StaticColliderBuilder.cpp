@@ -0,0 +1,110 @@
+#include "StaticColliderBuilder.h"
+#include <cmath>
+
+using namespace physx;
+
+
+//PhysX refuses to create aggregates with more actors than that
+static const size_t MAX_AGGREGATE_ACTORS = 128;
+
+
+StaticColliderBuilder::StaticColliderBuilder(PxPhysics& physics, PxMaterial& material, float regionSize)
+	: _physics(&physics), _material(&material), _regionSize(regionSize)
+{
+}
+
+StaticColliderBuilder::~StaticColliderBuilder()
+{
+	// the actors keep their own reference to the shapes
+	for (auto it = _boxShapes.begin(); it != _boxShapes.end(); ++it) {
+		it->second->release();
+	}
+}
+
+PxShape* StaticColliderBuilder::getBoxShape(const PxVec3& halfExtents)
+{
+	std::tuple<int, int, int> key(
+		static_cast<int>(std::lround(halfExtents.x * 1000.0f)),
+		static_cast<int>(std::lround(halfExtents.y * 1000.0f)),
+		static_cast<int>(std::lround(halfExtents.z * 1000.0f)));
+
+	auto it = _boxShapes.find(key);
+	if (it != _boxShapes.end())
+		return it->second;
+
+	// not exclusive, so any number of actors can use it
+	PxShape* shape = _physics->createShape(PxBoxGeometry(halfExtents), *_material, false);
+	_boxShapes[key] = shape;
+	return shape;
+}
+
+void StaticColliderBuilder::addBox(const PxTransform& pose, const PxVec3& halfExtents, void* userData)
+{
+	PendingBox box;
+	box.pose = pose;
+	box.halfExtents = halfExtents;
+	box.userData = userData;
+	_pending.push_back(box);
+}
+
+bool StaticColliderBuilder::hasPending()
+{
+	return !_pending.empty();
+}
+
+void StaticColliderBuilder::build(PxScene& scene, std::vector<PxRigidStatic*>& createdActors)
+{
+	std::map<std::pair<int, int>, std::vector<PxRigidStatic*>> regions;
+
+	for (size_t i = 0; i < _pending.size(); i++) {
+		const PendingBox& box = _pending[i];
+
+		PxRigidStatic* actor = _physics->createRigidStatic(box.pose);
+		actor->attachShape(*getBoxShape(box.halfExtents));
+		actor->userData = box.userData;
+		createdActors.push_back(actor);
+
+		// floor and outer limits span several regions, an aggregate around them would overlap everything
+		if (box.halfExtents.maxElement() * 2.0f > _regionSize) {
+			scene.addActor(*actor);
+			continue;
+		}
+
+		std::pair<int, int> region(
+			static_cast<int>(std::floor(box.pose.p.x / _regionSize)),
+			static_cast<int>(std::floor(box.pose.p.z / _regionSize)));
+		regions[region].push_back(actor);
+	}
+	_pending.clear();
+
+	for (auto it = regions.begin(); it != regions.end(); ++it) {
+		std::vector<PxRigidStatic*>& actors = it->second;
+
+		if (actors.size() == 1) {
+			scene.addActor(*actors[0]);
+			continue;
+		}
+
+		for (size_t begin = 0; begin < actors.size(); begin += MAX_AGGREGATE_ACTORS) {
+			size_t end = begin + MAX_AGGREGATE_ACTORS < actors.size() ? begin + MAX_AGGREGATE_ACTORS : actors.size();
+
+			// statics never collide with each other, no self collision needed
+			PxAggregate* aggregate = _physics->createAggregate(static_cast<PxU32>(end - begin), false);
+			for (size_t i = begin; i < end; i++) {
+				aggregate->addActor(*actors[i]);
+			}
+			scene.addAggregate(*aggregate);
+			_aggregates.push_back(aggregate);
+		}
+	}
+}
+
+unsigned int StaticColliderBuilder::getShapeCount()
+{
+	return static_cast<unsigned int>(_boxShapes.size());
+}
+
+unsigned int StaticColliderBuilder::getAggregateCount()
+{
+	return static_cast<unsigned int>(_aggregates.size());
+}
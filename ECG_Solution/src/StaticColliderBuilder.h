@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include "PxPhysicsAPI.h"
+
+
+/*
+Collects the static boxes of a level and turns them into as few PhysX objects as possible.
+Boxes with the same half extents share one PxShape, and the actors of every region of
+the maze are put into a PxAggregate, so the broadphase sees one bounding box per region
+instead of one per wall.
+*/
+class StaticColliderBuilder
+{
+private:
+	struct PendingBox {
+		physx::PxTransform pose;
+		physx::PxVec3 halfExtents;
+		void* userData;
+	};
+
+	physx::PxPhysics* _physics;
+	physx::PxMaterial* _material;
+	float _regionSize;
+
+	//shared shapes by half extents in millimeters
+	std::map<std::tuple<int, int, int>, physx::PxShape*> _boxShapes;
+	std::vector<PendingBox> _pending;
+	std::vector<physx::PxAggregate*> _aggregates;
+
+	physx::PxShape* getBoxShape(const physx::PxVec3& halfExtents);
+
+public:
+	//regionSize is the edge length of the square cells of the xz plane that share an aggregate
+	StaticColliderBuilder(physx::PxPhysics& physics, physx::PxMaterial& material, float regionSize = 30.0f);
+	~StaticColliderBuilder();
+
+	//remembers a box, nothing is created until build
+	void addBox(const physx::PxTransform& pose, const physx::PxVec3& halfExtents, void* userData);
+
+	bool hasPending();
+
+	//creates the actors for every box added since the last build and adds them to the scene
+	void build(physx::PxScene& scene, std::vector<physx::PxRigidStatic*>& createdActors);
+
+	unsigned int getShapeCount();
+	unsigned int getAggregateCount();
+};
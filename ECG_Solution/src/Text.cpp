@@ -1,4 +1,5 @@
 #include "Text.h"
+#include "GpuMemory.h"
 
 
 Text::Text(std::string text, glm::vec2 position, float scale, glm::vec3 color, std::map<GLchar, Character>& characters,Shader& shader)
@@ -10,7 +11,7 @@ Text::Text(std::string text, glm::vec2 position, float scale, glm::vec3 color, s
 	
 	glGenBuffers(1, &_vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+	gpuBufferData(PMEM_UI, GL_ARRAY_BUFFER, _vbo, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
 	
 	
 	glEnableVertexAttribArray(0);
@@ -22,15 +23,22 @@ Text::Text(std::string text, glm::vec2 position, float scale, glm::vec3 color, s
 
 Text::~Text() {
 
+	gpuDeleteBuffers(1, &_vbo);
 	glDeleteVertexArrays(1, &_vao);
 }
 
-void Text::setText(std::string newText) {
+void Text::setText(const std::string& newText) {
 
 	_text = newText;
 
 }
 
+void Text::setText(const char* newText) {
+
+	_text.assign(newText);
+
+}
+
 void Text::setColor(glm::vec3 color) {
 
 	_color = color;
@@ -53,7 +61,11 @@ void Text::drawText(bool isDashCooldown) {
 	for (chars = _text.begin(); chars != _text.end(); chars++)
 	{
 
-		Character ch = _characters[*chars];
+		// the subscript would insert a missing glyph
+		std::map<GLchar, Character>::const_iterator glyph = _characters.find(*chars);
+		if (glyph == _characters.end())
+			continue;
+		const Character& ch = glyph->second;
 
 		float xpos = xForCalc + ch.Bearing.x * _scale;
 		float ypos = _position.y - (ch.Size.y - ch.Bearing.y) * _scale;
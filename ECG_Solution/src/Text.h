@@ -36,7 +36,9 @@ public:
 	
 	~Text();
 
-	void setText(std::string newText);
+	// both reuse the memory of the old text once it was long enough
+	void setText(const std::string& newText);
+	void setText(const char* newText);
 	void setColor(glm::vec3 color);
 
 	void drawText(bool isDashCooldown = false);
@@ -0,0 +1,361 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+
+//chunks a parallelFor aims for per thread, so threads that finish early have something left to steal
+static const size_t CHUNKS_PER_THREAD = 4;
+
+//pool and deque of the current worker thread
+static thread_local const ThreadPool* tlsPool = nullptr;
+static thread_local int tlsQueue = -1;
+
+
+void JobCounter::increment()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_count++;
+}
+
+void JobCounter::decrement()
+{
+	std::vector<Dependent> dependents;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_count > 0)
+			return;
+		dependents.swap(_dependents);
+	}
+
+	// a waiting thread may destroy the counter as soon as the lock is released, only local state from here on
+	for (size_t i = 0; i < dependents.size(); i++) {
+		dependents[i].pool->enqueue(dependents[i].job, dependents[i].mainThread);
+	}
+}
+
+bool JobCounter::addDependent(const Dependent& dependent)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_count == 0)
+		return false;
+
+	_dependents.push_back(dependent);
+	return true;
+}
+
+bool JobCounter::isDone()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _count == 0;
+}
+
+
+ThreadPool::WorkQueue::WorkQueue()
+	: jobs(new PoolJob[QUEUE_CAPACITY])
+{
+}
+
+bool ThreadPool::WorkQueue::pushBack(const PoolJob& job)
+{
+	if (count == QUEUE_CAPACITY)
+		return false;
+
+	jobs[(head + count) % QUEUE_CAPACITY] = job;
+	count++;
+	return true;
+}
+
+bool ThreadPool::WorkQueue::popBack(PoolJob& job)
+{
+	if (count == 0)
+		return false;
+
+	count--;
+	job = jobs[(head + count) % QUEUE_CAPACITY];
+	return true;
+}
+
+bool ThreadPool::WorkQueue::popFront(PoolJob& job)
+{
+	if (count == 0)
+		return false;
+
+	job = jobs[head];
+	head = (head + 1) % QUEUE_CAPACITY;
+	count--;
+	return true;
+}
+
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	: _mainThread(std::this_thread::get_id()), _pendingJobs(0), _nextQueue(0)
+{
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++) {
+		_queues.emplace_back(new WorkQueue());
+	}
+
+	// the thread that creates the pool is the missing one, it owns the first deque
+	for (unsigned int i = 1; i < threadCount; i++) {
+		_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+
+	for (size_t i = 0; i < _workers.size(); i++) {
+		_workers[i].join();
+	}
+
+	// main thread jobs nobody ran any more, only their callables are freed
+	PoolJob job;
+	while (_mainThreadJobs.popFront(job)) {
+		job.invoke(job.data, false);
+	}
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return static_cast<unsigned int>(_workers.size()) + 1;
+}
+
+unsigned int ThreadPool::getWorkerCount() const
+{
+	return static_cast<unsigned int>(_workers.size());
+}
+
+int ThreadPool::getQueueIndex() const
+{
+	if (tlsPool == this)
+		return tlsQueue;
+	if (std::this_thread::get_id() == _mainThread)
+		return 0;
+	return -1;
+}
+
+void ThreadPool::push(const PoolJob& job)
+{
+	int index = getQueueIndex();
+	if (index < 0) {
+		index = static_cast<int>(_nextQueue.fetch_add(1) % _queues.size());
+	}
+
+	bool queued;
+	{
+		WorkQueue& queue = *_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queued = queue.pushBack(job);
+	}
+
+	// the deque is full, the work that is queued already keeps everyone busy
+	if (!queued) {
+		PoolJob overflow = job;
+		runJob(overflow);
+		return;
+	}
+	_pendingJobs.fetch_add(1);
+
+	// taking the lock makes sure a worker that is about to sleep sees the new job
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+	}
+	_condition.notify_one();
+}
+
+void ThreadPool::pushMainThread(const PoolJob& job)
+{
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(_mainThreadJobs.mutex);
+			if (_mainThreadJobs.pushBack(job))
+				return;
+		}
+
+		// only the main thread may run it, everyone else helps with other work until it made room
+		if (std::this_thread::get_id() == _mainThread) {
+			PoolJob overflow = job;
+			runJob(overflow);
+			return;
+		}
+		if (!runPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool ThreadPool::pop(PoolJob& job)
+{
+	int index = getQueueIndex();
+	if (index < 0)
+		return false;
+
+	// the newest job of the own deque, its data is most likely still in the cache
+	WorkQueue& queue = *_queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (!queue.popBack(job))
+		return false;
+
+	_pendingJobs.fetch_sub(1);
+	return true;
+}
+
+bool ThreadPool::steal(unsigned int thief, PoolJob& job)
+{
+	size_t count = _queues.size();
+	for (size_t i = 1; i <= count; i++) {
+		WorkQueue& queue = *_queues[(thief + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		// the oldest job, usually the biggest piece of work that is left
+		if (!queue.popFront(job))
+			continue;
+
+		_pendingJobs.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+bool ThreadPool::popMainThreadJob(PoolJob& job)
+{
+	std::lock_guard<std::mutex> lock(_mainThreadJobs.mutex);
+	return _mainThreadJobs.popFront(job);
+}
+
+void ThreadPool::runJob(PoolJob& job)
+{
+	job.invoke(job.data, true);
+	if (job.counter) {
+		job.counter->decrement();
+	}
+}
+
+bool ThreadPool::runPendingJob()
+{
+	int index = getQueueIndex();
+	PoolJob job;
+
+	if ((index == 0 && popMainThreadJob(job)) || pop(job) || steal(index < 0 ? 0 : index, job)) {
+		runJob(job);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::schedule(PoolJob job, JobCounter* counter, JobCounter* dependency, bool mainThread)
+{
+	if (counter) {
+		counter->increment();
+	}
+	job.counter = counter;
+
+	// parked on the dependency, whoever finishes its last job schedules this one
+	if (dependency) {
+		JobCounter::Dependent dependent;
+		dependent.pool = this;
+		dependent.job = job;
+		dependent.mainThread = mainThread;
+		if (dependency->addDependent(dependent))
+			return;
+	}
+	enqueue(job, mainThread);
+}
+
+void ThreadPool::enqueue(PoolJob& job, bool mainThread)
+{
+	if (mainThread) {
+		pushMainThread(job);
+	}
+	else if (_workers.empty()) {
+		runJob(job);
+	}
+	else {
+		push(job);
+	}
+}
+
+void ThreadPool::workerLoop(unsigned int index)
+{
+	tlsPool = this;
+	tlsQueue = static_cast<int>(index);
+
+	while (true) {
+		PoolJob job;
+		if (pop(job) || steal(index, job)) {
+			runJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this] { return _stop || _pendingJobs.load() > 0; });
+
+		if (_stop && _pendingJobs.load() == 0)
+			return;
+	}
+}
+
+void ThreadPool::runMainThreadJobs()
+{
+	// jobs that are queued by these jobs wait for the next call
+	size_t count;
+	{
+		std::lock_guard<std::mutex> lock(_mainThreadJobs.mutex);
+		count = _mainThreadJobs.count;
+	}
+
+	PoolJob job;
+	for (size_t i = 0; i < count && popMainThreadJob(job); i++) {
+		runJob(job);
+	}
+}
+
+void ThreadPool::wait(JobCounter& counter)
+{
+	while (!counter.isDone()) {
+		if (!runPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadPool::parallelForChunks(size_t count, void (*body)(const void* context, size_t begin, size_t end), const void* context, size_t grain)
+{
+	if (count == 0)
+		return;
+
+	grain = std::max<size_t>(grain, 1);
+	size_t threads = getThreadCount();
+
+	// not worth waking anybody up, run it right here
+	if (threads == 1 || count <= grain) {
+		body(context, 0, count);
+		return;
+	}
+
+	size_t targetChunks = threads * CHUNKS_PER_THREAD;
+	size_t chunkSize = std::max(grain, (count + targetChunks - 1) / targetChunks);
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// the chunks only hold pointers and numbers, so they are stored right in their jobs
+	JobCounter counter;
+	for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+		size_t begin = chunk * chunkSize;
+		size_t end = std::min(begin + chunkSize, count);
+		submit([body, context, begin, end] { body(context, begin, end); }, counter);
+	}
+
+	// the first chunk stays here, then help with the rest until all are done
+	body(context, 0, std::min(chunkSize, count));
+	wait(counter);
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+class ThreadPool;
+class JobCounter;
+
+/*
+A queued job. Small callables that can be copied as plain bytes, like lambdas that
+capture pointers and numbers, are stored right in the job, so queueing them never
+touches the heap. Anything else is moved to the heap and the job keeps a pointer to it.
+*/
+struct PoolJob
+{
+	static const size_t INLINE_BYTES = 48;
+
+	//runs the callable if execute is set and frees a callable that lives on the heap
+	void (*invoke)(void* data, bool execute) = nullptr;
+	JobCounter* counter = nullptr;
+	alignas(8) unsigned char data[INLINE_BYTES];
+
+	template <typename F>
+	static PoolJob create(F&& task)
+	{
+		typedef typename std::decay<F>::type Callable;
+		PoolJob job;
+		store<Callable>(job, std::forward<F>(task), std::integral_constant<bool, fitsInline<Callable>()>());
+		return job;
+	}
+
+private:
+	template <typename Callable>
+	static constexpr bool fitsInline()
+	{
+		return std::is_trivially_copyable<Callable>::value && std::is_trivially_destructible<Callable>::value
+			&& sizeof(Callable) <= INLINE_BYTES && alignof(Callable) <= 8;
+	}
+
+	template <typename Callable, typename F>
+	static void store(PoolJob& job, F&& task, std::true_type)
+	{
+		new (job.data) Callable(std::forward<F>(task));
+		job.invoke = [](void* data, bool execute) {
+			if (execute)
+				(*static_cast<Callable*>(data))();
+		};
+	}
+
+	template <typename Callable, typename F>
+	static void store(PoolJob& job, F&& task, std::false_type)
+	{
+		Callable* boxed = new Callable(std::forward<F>(task));
+		new (job.data) Callable*(boxed);
+		job.invoke = [](void* data, bool execute) {
+			Callable* callable = *static_cast<Callable**>(data);
+			if (execute)
+				(*callable)();
+			delete callable;
+		};
+	}
+};
+
+/*
+Counts the jobs of a group that are still running. A job that was submitted with a
+counter decrements it when it is done, jobs that depend on the counter are only
+scheduled once it reached zero. Waiting on a counter with ThreadPool::wait runs
+other jobs in the meantime instead of blocking the thread.
+The counter has to outlive all jobs that reference it.
+*/
+class JobCounter
+{
+private:
+	friend class ThreadPool;
+
+	//a job that waits for this counter, scheduled when it drops to zero
+	struct Dependent {
+		ThreadPool* pool;
+		PoolJob job;
+		bool mainThread;
+	};
+
+	std::mutex _mutex;
+	int _count = 0;
+	std::vector<Dependent> _dependents;
+
+	void increment();
+	void decrement();
+
+	//false if the counter is done already, the job has to be scheduled by the caller then
+	bool addDependent(const Dependent& dependent);
+
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool isDone();
+};
+
+/*
+A work-stealing job system that is shared by the engine subsystems.
+Every thread of the pool owns a deque: it takes its own jobs from the back and,
+once it runs dry, steals the oldest job from the front of another one. The thread
+that creates the pool owns the first deque and helps with the work whenever it waits,
+so a pool with zero workers simply runs everything on that thread.
+Jobs that have to run on the main thread, like GL calls, go into a separate queue
+that is drained by runMainThreadJobs.
+The deques are rings of a fixed size that are allocated with the pool, a job that
+finds its deque full is run right away by the thread that submits it.
+*/
+class ThreadPool
+{
+private:
+	friend class JobCounter;
+
+	static const size_t QUEUE_CAPACITY = 1024;
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::unique_ptr<PoolJob[]> jobs;
+		size_t head = 0;
+		size_t count = 0;
+
+		WorkQueue();
+
+		//all of them expect the mutex to be held, push returns false if the ring is full
+		bool pushBack(const PoolJob& job);
+		bool popBack(PoolJob& job);
+		bool popFront(PoolJob& job);
+	};
+
+	std::vector<std::thread> _workers;
+	//one per thread of the pool, index 0 belongs to the thread that created it
+	std::vector<std::unique_ptr<WorkQueue>> _queues;
+	std::thread::id _mainThread;
+
+	WorkQueue _mainThreadJobs;
+
+	//jobs sitting in any of the deques, workers sleep while there are none
+	std::atomic<int> _pendingJobs;
+	//deque that gets the next job submitted from a thread outside of the pool
+	std::atomic<unsigned int> _nextQueue;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stop = false;
+
+	void workerLoop(unsigned int index);
+
+	//index of the deque owned by the calling thread, -1 for threads outside of the pool
+	int getQueueIndex() const;
+
+	void push(const PoolJob& job);
+	void pushMainThread(const PoolJob& job);
+	bool pop(PoolJob& job);
+	bool steal(unsigned int thief, PoolJob& job);
+	bool popMainThreadJob(PoolJob& job);
+	void runJob(PoolJob& job);
+
+	//runs one job if there is one, returns false if there was nothing to do
+	bool runPendingJob();
+
+	void schedule(PoolJob job, JobCounter* counter, JobCounter* dependency, bool mainThread);
+	//queues a job whose dependency is done
+	void enqueue(PoolJob& job, bool mainThread);
+
+	//calls body(context, begin, end) for the chunks, see the template below
+	void parallelForChunks(size_t count, void (*body)(const void* context, size_t begin, size_t end), const void* context, size_t grain);
+
+public:
+
+	//threadCount includes the calling thread, so the pool starts one worker less
+	//0 uses the hardware concurrency
+	ThreadPool(unsigned int threadCount = 0);
+
+	~ThreadPool();
+
+	//number of threads that work on a parallelFor, including the calling thread
+	unsigned int getThreadCount() const;
+
+	//number of worker threads, without the calling thread
+	unsigned int getWorkerCount() const;
+
+	//runs task on one of the workers and returns right away, runs it right here if there are no workers
+	template <typename F>
+	void submit(F&& task)
+	{
+		if (_workers.empty()) {
+			task();
+			return;
+		}
+
+		schedule(PoolJob::create(std::forward<F>(task)), nullptr, nullptr, false);
+	}
+
+	//like submit, counter is decremented once the task is done
+	//with a dependency the task is only started after that counter reached zero
+	template <typename F>
+	void submit(F&& task, JobCounter& counter, JobCounter* dependency = nullptr)
+	{
+		schedule(PoolJob::create(std::forward<F>(task)), &counter, dependency, false);
+	}
+
+	//task runs on the thread that created the pool, the next time it calls runMainThreadJobs or waits
+	template <typename F>
+	void submitMainThread(F&& task, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+	{
+		schedule(PoolJob::create(std::forward<F>(task)), counter, dependency, true);
+	}
+
+	//runs all main thread jobs that are queued right now, only call it from the thread that created the pool
+	void runMainThreadJobs();
+
+	//runs other jobs until counter is done
+	void wait(JobCounter& counter);
+
+	//calls func(begin, end) for chunks of [0, count) with at least grain elements each and waits until all are done
+	//can be called from inside a job, the waiting thread keeps working on other jobs
+	template <typename F>
+	void parallelFor(size_t count, const F& func, size_t grain = 1)
+	{
+		parallelForChunks(count, [](const void* context, size_t begin, size_t end) {
+			(*static_cast<const F*>(context))(begin, end);
+		}, &func, grain);
+	}
+};
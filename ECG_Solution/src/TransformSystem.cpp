@@ -0,0 +1,132 @@
+#include "TransformSystem.h"
+#include <glm/gtc/matrix_inverse.hpp>
+#include "FrameProfiler.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define TRANSFORM_SSE 1
+#endif
+
+
+//columns closer to orthogonal than this are treated as rotation and scale
+static const float ORTHOGONAL_EPSILON = 1e-6f;
+
+
+//out = a * b, both column major, out must not be a or b
+static void multiplyTransforms(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#ifdef TRANSFORM_SSE
+	const float* left = &a[0][0];
+	const float* right = &b[0][0];
+	float* result = &out[0][0];
+
+	__m128 column0 = _mm_loadu_ps(left);
+	__m128 column1 = _mm_loadu_ps(left + 4);
+	__m128 column2 = _mm_loadu_ps(left + 8);
+	__m128 column3 = _mm_loadu_ps(left + 12);
+
+	// every column of the result is the columns of a weighted by one column of b
+	for (int i = 0; i < 4; i++) {
+		const float* weights = right + i * 4;
+		__m128 sum = _mm_mul_ps(column0, _mm_set1_ps(weights[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column1, _mm_set1_ps(weights[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column2, _mm_set1_ps(weights[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column3, _mm_set1_ps(weights[3])));
+		_mm_storeu_ps(result + i * 4, sum);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+
+glm::mat3 computeNormalMatrix(const glm::mat4& world)
+{
+	glm::vec3 x = glm::vec3(world[0]);
+	glm::vec3 y = glm::vec3(world[1]);
+	glm::vec3 z = glm::vec3(world[2]);
+
+	float xx = glm::dot(x, x);
+	float yy = glm::dot(y, y);
+	float zz = glm::dot(z, z);
+	float xy = glm::dot(x, y);
+	float xz = glm::dot(x, z);
+	float yz = glm::dot(y, z);
+
+	// rotation times scale, the inverse transpose is every column divided by its squared length
+	bool orthogonal = xy * xy <= ORTHOGONAL_EPSILON * xx * yy
+		&& xz * xz <= ORTHOGONAL_EPSILON * xx * zz
+		&& yz * yz <= ORTHOGONAL_EPSILON * yy * zz;
+	if (orthogonal && xx > 0.0f && yy > 0.0f && zz > 0.0f)
+		return glm::mat3(x / xx, y / yy, z / zz);
+
+	return glm::inverseTranspose(glm::mat3(world));
+}
+
+void setLocalTransform(Registry& scene, Entity entity, const glm::mat4& local)
+{
+	TransformComponent* transform = scene.getTransforms().get(entity);
+	if (!transform)
+		return;
+
+	transform->local = local;
+	transform->dirty = true;
+}
+
+void setParent(Registry& scene, Entity child, Entity parent)
+{
+	ComponentPool<TransformComponent>& pool = scene.getTransforms();
+	TransformComponent* transform = pool.get(child);
+	if (!transform || child == parent)
+		return;
+
+	transform->parent = parent;
+	transform->dirty = true;
+
+	// depth of every entity, a chain longer than the pool is a cycle and is cut there
+	const std::vector<Entity>& entities = pool.getEntities();
+	Entity lastEntity = 0;
+	for (size_t i = 0; i < entities.size(); i++) {
+		lastEntity = entities[i] > lastEntity ? entities[i] : lastEntity;
+	}
+	std::vector<unsigned int> depths(lastEntity + 1, 0);
+	for (size_t i = 0; i < entities.size(); i++) {
+		unsigned int depth = 0;
+		const TransformComponent* current = &pool.getComponents()[i];
+		while (current->parent != NO_ENTITY && depth < entities.size()) {
+			current = pool.get(current->parent);
+			if (!current)
+				break;
+			depth++;
+		}
+		depths[entities[i]] = depth;
+	}
+
+	// roots first, then their children and so on, siblings keep their order
+	pool.sort([&depths](Entity a, Entity b) { return depths[a] < depths[b]; });
+}
+
+void updateTransforms(Registry& scene)
+{
+	PROFILE_SCOPE("transforms");
+
+	ComponentPool<TransformComponent>& pool = scene.getTransforms();
+	std::vector<TransformComponent>& transforms = pool.getComponents();
+
+	for (size_t i = 0; i < transforms.size(); i++) {
+		TransformComponent& transform = transforms[i];
+
+		// a destroyed parent leaves its children at the root
+		const TransformComponent* parent = transform.parent != NO_ENTITY ? pool.get(transform.parent) : nullptr;
+		transform.moved = transform.dirty || (parent && parent->moved);
+		transform.dirty = false;
+		if (!transform.moved)
+			continue;
+
+		if (parent)
+			multiplyTransforms(parent->world, transform.local, transform.world);
+		else
+			transform.world = transform.local;
+		transform.normal = computeNormalMatrix(transform.world);
+	}
+}
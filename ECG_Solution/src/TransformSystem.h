@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Registry.h"
+
+
+//inverse transpose of the upper 3x3, without an inverse for rotations and scales, only sheared matrices need one
+glm::mat3 computeNormalMatrix(const glm::mat4& world);
+
+//marks the transform dirty, its world and the ones of its children are recomputed with the next update
+void setLocalTransform(Registry& scene, Entity entity, const glm::mat4& local);
+
+//local becomes relative to the parent, NO_ENTITY detaches the entity again
+//destroy the children of an entity before the entity itself, ids are handed out again
+void setParent(Registry& scene, Entity child, Entity parent);
+
+/*
+Recomputes the world and normal matrices of every dirty transform and of all their children.
+The pool keeps every parent in front of its children, so a single pass over the dense
+array sees the parents updated already. Clean transforms cost a flag check.
+*/
+void updateTransforms(Registry& scene);
@@ -0,0 +1,263 @@
+/*
+Headless benchmark of the particle simulation, no window and no GL context.
+Runs N emitters with M particles each for a fixed number of steps, once per thread
+count, and reports the time per live particle of every simulation phase.
+
+usage: ParticleBenchmark [--emitters N] [--particles M] [--steps S] [--threads 1,2,4]
+                         [--blend alpha|additive] [--seed X] [--format json|csv]
+*/
+#include "../../ECG_Solution/src/ParticleEmitter.h"
+#include "../../ECG_Solution/src/ThreadPool.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+
+enum BenchmarkPhase {
+	PHASE_SPAWN,
+	PHASE_UPDATE,
+	PHASE_SORT,
+	PHASE_PACK,
+	PHASE_COUNT
+};
+
+static const char* phaseNames[PHASE_COUNT] = { "spawn", "update", "sort", "pack" };
+
+struct BenchmarkConfig {
+	unsigned int emitters = 64;
+	unsigned int particles = 1000;
+	unsigned int steps = 600;
+	float deltaTime = 1.0f / 60.0f;
+	float life = 2.0f;
+	std::vector<unsigned int> threads;
+	ParticleBlendMode blendMode = PBLEND_ALPHA;
+	unsigned int seed = 1;
+	bool csv = false;
+};
+
+struct BenchmarkResult {
+	unsigned int threads = 0;
+	double phaseNs[PHASE_COUNT] = {};
+	//particles each phase worked on, summed over all steps
+	double phaseParticles[PHASE_COUNT] = {};
+	double totalNs = 0.0;
+	double averageAlive = 0.0;
+};
+
+
+static std::vector<unsigned int> parseThreadList(const char* list)
+{
+	std::vector<unsigned int> threads;
+	std::stringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		int count = std::atoi(item.c_str());
+		if (count > 0)
+			threads.push_back(static_cast<unsigned int>(count));
+	}
+	return threads;
+}
+
+//1, 2, 4, ... up to the hardware concurrency, which is always included
+static std::vector<unsigned int> defaultThreadList()
+{
+	unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> threads;
+	for (unsigned int count = 1; count < hardware; count *= 2) {
+		threads.push_back(count);
+	}
+	threads.push_back(hardware);
+	return threads;
+}
+
+static bool parseArguments(int argc, char** argv, BenchmarkConfig& config)
+{
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (value == nullptr) {
+			std::cerr << "missing value for " << arg << std::endl;
+			return false;
+		}
+
+		if (std::strcmp(arg, "--emitters") == 0)
+			config.emitters = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		else if (std::strcmp(arg, "--particles") == 0)
+			config.particles = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		else if (std::strcmp(arg, "--steps") == 0)
+			config.steps = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		else if (std::strcmp(arg, "--threads") == 0)
+			config.threads = parseThreadList(value);
+		else if (std::strcmp(arg, "--blend") == 0)
+			config.blendMode = std::strcmp(value, "additive") == 0 ? PBLEND_ADDITIVE : PBLEND_ALPHA;
+		else if (std::strcmp(arg, "--seed") == 0)
+			config.seed = static_cast<unsigned int>(std::atoi(value));
+		else if (std::strcmp(arg, "--format") == 0)
+			config.csv = std::strcmp(value, "csv") == 0;
+		else {
+			std::cerr << "unknown argument " << arg << std::endl;
+			return false;
+		}
+		i++;
+	}
+
+	if (config.threads.empty())
+		config.threads = defaultThreadList();
+	return true;
+}
+
+
+//emitters on a grid, seeded the same way for every run so every thread count does identical work
+static std::vector<std::unique_ptr<ParticleEmitter>> createEmitters(const BenchmarkConfig& config)
+{
+	EmitterSettings settings;
+	settings.amount = config.particles;
+	settings.life = config.life;
+	settings.blendMode = config.blendMode;
+	// enough spawns per step to keep the pool full once the first particles die
+	settings.spawnCount = static_cast<unsigned int>(std::ceil(config.particles * config.deltaTime / config.life));
+
+	unsigned int gridSize = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<float>(config.emitters))));
+
+	std::vector<std::unique_ptr<ParticleEmitter>> emitters;
+	for (unsigned int i = 0; i < config.emitters; i++) {
+		settings.position = glm::vec3((i % gridSize) * 5.0f, 0.0f, (i / gridSize) * 5.0f);
+		emitters.push_back(std::unique_ptr<ParticleEmitter>(new ParticleEmitter(settings, config.seed + i)));
+	}
+	return emitters;
+}
+
+static BenchmarkResult runBenchmark(const BenchmarkConfig& config, unsigned int threads)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	ThreadPool pool(threads);
+
+	std::vector<std::unique_ptr<ParticleEmitter>> emitters = createEmitters(config);
+	unsigned int spawnCount = emitters.front()->getSettings().spawnCount;
+
+	auto runPhase = [&](const std::function<void(ParticleEmitter&)>& phase) -> double {
+		Clock::time_point start = Clock::now();
+		auto range = [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				phase(*emitters[i]);
+			}
+		};
+		pool.parallelFor(emitters.size(), range);
+		return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+	};
+
+	auto countAlive = [&]() -> double {
+		double alive = 0.0;
+		for (size_t i = 0; i < emitters.size(); i++) {
+			alive += emitters[i]->getStats().alive;
+		}
+		return alive;
+	};
+
+	BenchmarkResult result;
+	result.threads = threads;
+
+	// one lifetime of untimed warm up so the timed steps run with full pools
+	unsigned int warmupSteps = static_cast<unsigned int>(std::ceil(config.life / config.deltaTime));
+	for (unsigned int step = 0; step < warmupSteps + config.steps; step++) {
+		// the camera circles the grid so the sort order keeps changing
+		float angle = step * config.deltaTime * 0.5f;
+		glm::vec3 camera = glm::vec3(std::cos(angle), 0.3f, std::sin(angle)) * 50.0f;
+		float deltaTime = config.deltaTime;
+
+		double phaseNs[PHASE_COUNT];
+		phaseNs[PHASE_SPAWN] = runPhase([spawnCount](ParticleEmitter& emitter) { emitter.Spawn(spawnCount, glm::vec3(0.0f)); });
+		double aliveBefore = countAlive() + static_cast<double>(spawnCount) * emitters.size();
+		phaseNs[PHASE_UPDATE] = runPhase([deltaTime, camera](ParticleEmitter& emitter) { emitter.Integrate(deltaTime, camera); });
+		double alive = countAlive();
+		phaseNs[PHASE_SORT] = runPhase([](ParticleEmitter& emitter) { emitter.Sort(); });
+		phaseNs[PHASE_PACK] = runPhase([camera](ParticleEmitter& emitter) { emitter.Pack(camera); });
+
+		if (step < warmupSteps)
+			continue;
+
+		result.phaseParticles[PHASE_SPAWN] += static_cast<double>(spawnCount) * emitters.size();
+		result.phaseParticles[PHASE_UPDATE] += aliveBefore;
+		result.phaseParticles[PHASE_SORT] += alive;
+		result.phaseParticles[PHASE_PACK] += alive;
+		result.averageAlive += alive;
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			result.phaseNs[phase] += phaseNs[phase];
+			result.totalNs += phaseNs[phase];
+		}
+	}
+	result.averageAlive /= config.steps;
+	return result;
+}
+
+
+static double nsPerParticle(const BenchmarkResult& result, int phase)
+{
+	return result.phaseParticles[phase] > 0.0 ? result.phaseNs[phase] / result.phaseParticles[phase] : 0.0;
+}
+
+static void writeJson(std::ostream& out, const BenchmarkConfig& config, const std::vector<BenchmarkResult>& results)
+{
+	out << "{\n";
+	out << "  \"benchmark\": \"particles\",\n";
+	out << "  \"emitters\": " << config.emitters << ",\n";
+	out << "  \"particlesPerEmitter\": " << config.particles << ",\n";
+	out << "  \"steps\": " << config.steps << ",\n";
+	out << "  \"blend\": \"" << (config.blendMode == PBLEND_ALPHA ? "alpha" : "additive") << "\",\n";
+	out << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		out << "    {\"threads\": " << result.threads
+			<< ", \"averageAlive\": " << result.averageAlive
+			<< ", \"totalMs\": " << result.totalNs / 1.0e6
+			<< ", \"speedup\": " << results.front().totalNs / result.totalNs
+			<< ", \"nsPerParticle\": {";
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			out << (phase > 0 ? ", " : "") << "\"" << phaseNames[phase] << "\": " << nsPerParticle(result, phase);
+		}
+		out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+static void writeCsv(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+	out << "threads,phase,total_ms,ns_per_particle,speedup\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			out << result.threads << "," << phaseNames[phase] << "," << result.phaseNs[phase] / 1.0e6 << ","
+				<< nsPerParticle(result, phase) << "," << results.front().phaseNs[phase] / result.phaseNs[phase] << "\n";
+		}
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	BenchmarkConfig config;
+	if (!parseArguments(argc, argv, config))
+		return EXIT_FAILURE;
+
+	std::vector<BenchmarkResult> results;
+	for (size_t i = 0; i < config.threads.size(); i++) {
+		results.push_back(runBenchmark(config, config.threads[i]));
+	}
+
+	if (config.csv)
+		writeCsv(std::cout, results);
+	else
+		writeJson(std::cout, config, results);
+
+	return EXIT_SUCCESS;
+}
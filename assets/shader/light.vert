@@ -12,13 +12,13 @@ out VS_OUT {
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 modelMatrix;
+uniform mat3 normalMatrix;
 
 void main()
 {
     vs_out.FragPos = vec3(modelMatrix * vec4(aPos, 1.0));   
     vs_out.TexCoords = aTexCoords;
         
-    mat3 normalMatrix = transpose(inverse(mat3(modelMatrix)));
     vs_out.Normal = normalize(normalMatrix * aNormal);
     
     gl_Position = projection * view * modelMatrix* vec4(aPos, 1.0);
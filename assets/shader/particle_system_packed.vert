@@ -0,0 +1,49 @@
+#version 430 core
+
+// Packed variant of particle_system.vert
+// Positions arrive as half floats relative to the camera, colors as rgba8
+// and the optional rotation/flipbook frame as two 16 bit integers
+
+// Input attributes
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec4 particlePositionSize;
+layout(location = 2) in vec4 particleColor;
+layout(location = 3) in uvec2 particleRotationFrame;
+
+// Uniforms
+uniform mat4 viewProjectionMatrix;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraOrigin;
+
+// Output to fragment shader
+out vec4 color;
+flat out int flipbookFrame;
+
+const float ROTATION_SCALE = 6.28318530718 / 65535.0;
+
+void main() {
+    // Undo the camera relative packing to get the particle's position in world space
+    vec3 particlePosition = cameraOrigin + particlePositionSize.xyz;
+    float particleSize = particlePositionSize.w;
+
+    // Rotate the billboard corner around the quad center
+    float angle = float(particleRotationFrame.x) * ROTATION_SCALE;
+    float s = sin(angle);
+    float c = cos(angle);
+    vec2 corner = vec2(c * vertexPosition_modelspace.x - s * vertexPosition_modelspace.y,
+                       s * vertexPosition_modelspace.x + c * vertexPosition_modelspace.y);
+
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+
+    vec3 vertexPosition = particlePosition
+                        + cameraRight * corner.x * particleSize
+                        + cameraUp * corner.y * particleSize;
+
+    gl_Position = projection * view * vec4(vertexPosition, 1.0);
+
+    // Pass the color and the flipbook frame to the fragment shader
+    color = particleColor;
+    flipbookFrame = int(particleRotationFrame.y);
+}